@@ -3,6 +3,7 @@
 #include <array>
 #include <cmath>
 #include <regex>
+#include <atomic>
 #include <ranges>
 #include <string>
 #include <cstring>
@@ -57,6 +58,48 @@ constexpr bool static_assert_aprs_mic_e_messages(std::index_sequence<I ...>)
 }
 static_assert(static_assert_aprs_mic_e_messages(std::make_index_sequence<APRS_MIC_E_MESSAGES_COUNT> {}));
 
+// copies of a reference count start out with a single reference
+struct aprs_reference_count
+{
+#if defined(APRSERVICE_ATOMIC_REFERENCE_COUNT)
+	std::atomic<size_t> value;
+#else
+	size_t              value;
+#endif
+
+	aprs_reference_count(size_t value = 1)
+		: value(value)
+	{
+	}
+	aprs_reference_count(const aprs_reference_count&)
+		: value(1)
+	{
+	}
+};
+// hashes are computed on first use by whichever thread gets there first, every thread computes the same value
+struct aprs_hash_cache
+{
+	std::atomic<uint64_t> value;
+
+	aprs_hash_cache(uint64_t value = 0)
+		: value(value)
+	{
+	}
+	aprs_hash_cache(const aprs_hash_cache& cache)
+		: value(cache.load())
+	{
+	}
+
+	uint64_t load() const
+	{
+		return value.load(std::memory_order_relaxed);
+	}
+	void     store(uint64_t value)
+	{
+		this->value.store(value, std::memory_order_relaxed);
+	}
+};
+
 struct aprs_path
 {
 	uint8_t                       size;
@@ -65,7 +108,8 @@ struct aprs_path
 
 	std::string                   string;
 
-	size_t                        reference_count;
+	aprs_hash_cache               hash;
+	aprs_reference_count          reference_count;
 };
 
 struct aprs_packet_data_extensions
@@ -98,60 +142,70 @@ struct aprs_packet_data_extensions
 
 struct aprs_packet_gps
 {
-	std::string nmea;
-	std::string comment;
+	std::string          nmea;
+	std::string          comment;
+
+	aprs_reference_count reference_count;
 };
 struct aprs_packet_item
 {
-	bool        is_alive;
-	bool        is_compressed;
+	bool                 is_alive;
+	bool                 is_compressed;
+
+	aprs_time            time;
 
-	aprs_time   time;
+	std::string          name;
+	std::string          comment;
 
-	std::string name;
-	std::string comment;
+	float                latitude;
+	float                longitude;
 
-	float       latitude;
-	float       longitude;
+	char                 symbol_table;
+	char                 symbol_table_key;
 
-	char        symbol_table;
-	char        symbol_table_key;
+	aprs_reference_count reference_count;
 };
 typedef aprs_packet_item aprs_packet_object;
 struct aprs_packet_status
 {
-	bool        is_time_set;
+	bool                 is_time_set;
 
-	aprs_time   time;
-	std::string message;
+	aprs_time            time;
+	std::string          message;
+
+	aprs_reference_count reference_count;
 };
 struct aprs_packet_message
 {
-	std::string        id;
-	APRS_MESSAGE_TYPES type;
-	std::string        content;
-	std::string        destination;
+	std::string          id;
+	APRS_MESSAGE_TYPES   type;
+	std::string          content;
+	std::string          destination;
+
+	aprs_reference_count reference_count;
 };
 struct aprs_packet_weather
 {
-	bool        is_raw;
+	bool                 is_raw;
 
-	aprs_time   time;
+	aprs_time            time;
 
-	uint16_t    wind_speed;
-	uint16_t    wind_speed_gust;
-	uint16_t    wind_direction;
+	uint16_t             wind_speed;
+	uint16_t             wind_speed_gust;
+	uint16_t             wind_direction;
 
-	uint16_t    rainfall_last_hour;
-	uint16_t    rainfall_last_24_hours;
-	uint16_t    rainfall_since_midnight;
+	uint16_t             rainfall_last_hour;
+	uint16_t             rainfall_last_24_hours;
+	uint16_t             rainfall_since_midnight;
 
-	uint8_t     humidity;
-	int16_t     temperature;
-	uint32_t    barometric_pressure;
+	uint8_t              humidity;
+	int16_t              temperature;
+	uint32_t             barometric_pressure;
 
-	std::string type;
-	char        software;
+	std::string          type;
+	char                 software;
+
+	aprs_reference_count reference_count;
 };
 struct aprs_packet_position
 {
@@ -170,6 +224,8 @@ struct aprs_packet_position
 	APRS_MIC_E_MESSAGES    mic_e_message;
 	std::array<uint8_t, 5> mic_e_telemetry;
 	uint8_t                mic_e_telemetry_channels;
+
+	aprs_reference_count   reference_count;
 };
 struct aprs_packet_telemetry
 {
@@ -194,16 +250,29 @@ struct aprs_packet_telemetry
 	uint8_t                                   digital;
 	uint16_t                                  sequence;
 	std::string                               comment;
+
+	aprs_reference_count                      reference_count;
 };
 struct aprs_packet_user_defined
 {
-	char        id;
-	char        type;
-	std::string data;
+	char                 id;
+	char                 type;
+	std::string          data;
+
+	aprs_reference_count reference_count;
 };
 struct aprs_packet_third_party
 {
-	std::string content;
+	std::string          content;
+
+	aprs_reference_count reference_count;
+};
+// the information field is shared between copies of a packet the same way the payload is
+struct aprs_packet_content
+{
+	std::string          value;
+
+	aprs_reference_count reference_count;
 };
 struct aprs_packet
 {
@@ -212,13 +281,14 @@ struct aprs_packet
 	std::string                 igate;
 	std::string                 tocall;
 	std::string                 sender;
-	std::string                 content;
+	aprs_packet_content*        content;
 	std::string                 qconstruct;
 	aprs_packet_data_extensions extensions;
 
 	std::string                 string;
 
-	size_t                      reference_count;
+	aprs_hash_cache             hash;
+	aprs_reference_count        reference_count;
 
 	union
 	{
@@ -274,6 +344,180 @@ constexpr T        aprs_from_float(float value, float& fraction)
 	return value;
 }
 
+constexpr uint64_t APRS_HASH_SECRET[] = { 0xa0761d6478bd642f, 0xe7037ed1a0b428db, 0x8ebc6af09c88c6e3, 0x589965cc75374cc3 };
+
+void               aprs_hash_mum(uint64_t& a, uint64_t& b)
+{
+#if defined(__SIZEOF_INT128__)
+	auto value = static_cast<unsigned __int128>(a) * b;
+
+	a = static_cast<uint64_t>(value);
+	b = static_cast<uint64_t>(value >> 64);
+#else
+	uint64_t a_hi = a >> 32, a_lo = static_cast<uint32_t>(a);
+	uint64_t b_hi = b >> 32, b_lo = static_cast<uint32_t>(b);
+	uint64_t hh   = a_hi * b_hi, hl = a_hi * b_lo, lh = a_lo * b_hi, ll = a_lo * b_lo;
+	uint64_t t    = ll + (hl << 32);
+	uint64_t lo   = t + (lh << 32);
+	uint64_t hi   = hh + (hl >> 32) + (lh >> 32) + (t < ll) + (lo < t);
+
+	a = lo;
+	b = hi;
+#endif
+}
+uint64_t           aprs_hash_mix(uint64_t a, uint64_t b)
+{
+	aprs_hash_mum(a, b);
+
+	return a ^ b;
+}
+uint64_t           aprs_hash_read32(const uint8_t* data)
+{
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+
+	return value;
+}
+uint64_t           aprs_hash_read64(const uint8_t* data)
+{
+	uint64_t value;
+	memcpy(&value, data, sizeof(value));
+
+	return value;
+}
+// wyhash (final version) by Wang Yi, public domain
+uint64_t           aprs_hash(const void* data, size_t size, uint64_t seed)
+{
+	auto     p = static_cast<const uint8_t*>(data);
+	uint64_t a, b;
+
+	seed ^= aprs_hash_mix(seed ^ APRS_HASH_SECRET[0], APRS_HASH_SECRET[1]);
+
+	if (size <= 16)
+	{
+		if (size >= 4)
+		{
+			a = (aprs_hash_read32(p) << 32) | aprs_hash_read32(p + ((size >> 3) << 2));
+			b = (aprs_hash_read32(p + size - 4) << 32) | aprs_hash_read32(p + size - 4 - ((size >> 3) << 2));
+		}
+		else if (size > 0)
+		{
+			a = (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[size >> 1]) << 8) | p[size - 1];
+			b = 0;
+		}
+		else
+			a = b = 0;
+	}
+	else
+	{
+		size_t i = size;
+
+		if (i > 48)
+		{
+			uint64_t seed1 = seed;
+			uint64_t seed2 = seed;
+
+			do
+			{
+				seed  = aprs_hash_mix(aprs_hash_read64(p)      ^ APRS_HASH_SECRET[1], aprs_hash_read64(p + 8)  ^ seed);
+				seed1 = aprs_hash_mix(aprs_hash_read64(p + 16) ^ APRS_HASH_SECRET[2], aprs_hash_read64(p + 24) ^ seed1);
+				seed2 = aprs_hash_mix(aprs_hash_read64(p + 32) ^ APRS_HASH_SECRET[3], aprs_hash_read64(p + 40) ^ seed2);
+				p    += 48;
+				i    -= 48;
+			} while (i > 48);
+
+			seed ^= seed1 ^ seed2;
+		}
+
+		for (; i > 16; i -= 16, p += 16)
+			seed = aprs_hash_mix(aprs_hash_read64(p) ^ APRS_HASH_SECRET[1], aprs_hash_read64(p + 8) ^ seed);
+
+		a = aprs_hash_read64(p + i - 16);
+		b = aprs_hash_read64(p + i - 8);
+	}
+
+	a ^= APRS_HASH_SECRET[1];
+	b ^= seed;
+	aprs_hash_mum(a, b);
+
+	return aprs_hash_mix(a ^ APRS_HASH_SECRET[0] ^ size, b ^ APRS_HASH_SECRET[1]);
+}
+uint64_t           aprs_hash(uint64_t seed, std::string_view value)
+{
+	return aprs_hash(value.data(), value.length(), seed);
+}
+uint64_t           aprs_hash(uint64_t seed, float value)
+{
+	if (value == 0)
+		value = 0; // -0 == 0
+
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	return aprs_hash_mix(seed ^ APRS_HASH_SECRET[0], bits ^ APRS_HASH_SECRET[1]);
+}
+template<typename T>
+	requires std::is_integral<T>::value || std::is_enum<T>::value
+uint64_t           aprs_hash(uint64_t seed, T value)
+{
+	return aprs_hash_mix(seed ^ APRS_HASH_SECRET[0], static_cast<uint64_t>(value) ^ APRS_HASH_SECRET[1]);
+}
+void               aprs_reference_count_add(aprs_reference_count& reference_count)
+{
+#if defined(APRSERVICE_ATOMIC_REFERENCE_COUNT)
+	reference_count.value.fetch_add(1, std::memory_order_relaxed);
+#else
+	++reference_count.value;
+#endif
+}
+// @return true if this was the last reference
+bool               aprs_reference_count_release(aprs_reference_count& reference_count)
+{
+#if defined(APRSERVICE_ATOMIC_REFERENCE_COUNT)
+	return reference_count.value.fetch_sub(1, std::memory_order_acq_rel) == 1;
+#else
+	return !--reference_count.value;
+#endif
+}
+size_t             aprs_reference_count_get(const aprs_reference_count& reference_count)
+{
+#if defined(APRSERVICE_ATOMIC_REFERENCE_COUNT)
+	return reference_count.value.load(std::memory_order_acquire);
+#else
+	return reference_count.value;
+#endif
+}
+
+// hashes the same fields as aprs_time_compare
+uint64_t           aprs_hash(uint64_t seed, const aprs_time& value)
+{
+	seed = aprs_hash(seed, value.type);
+
+	if (value.type & APRS_TIME_DHM)
+	{
+		seed = aprs_hash(seed, value.tm.tm_mday);
+		seed = aprs_hash(seed, value.tm.tm_min);
+		seed = aprs_hash(seed, value.tm.tm_sec);
+	}
+
+	if (value.type & APRS_TIME_HMS)
+	{
+		seed = aprs_hash(seed, value.tm.tm_hour);
+		seed = aprs_hash(seed, value.tm.tm_min);
+		seed = aprs_hash(seed, value.tm.tm_sec);
+	}
+
+	if ((value.type & APRS_TIME_MDHM) == APRS_TIME_MDHM)
+	{
+		seed = aprs_hash(seed, value.tm.tm_mon);
+		seed = aprs_hash(seed, value.tm.tm_mday);
+		seed = aprs_hash(seed, value.tm.tm_hour);
+		seed = aprs_hash(seed, value.tm.tm_min);
+	}
+
+	return seed;
+}
+
 bool               aprs_regex_match(aprs_regex_match_result& match, const aprs_regex_pattern& regex, std::string_view string)
 {
 	if (string.empty())
@@ -503,6 +747,80 @@ bool               aprs_extract_path_node(std::string& station, bool& repeated,
 
 	return true;
 }
+// address is 6 shifted characters padded with spaces followed by the ssid byte
+bool               aprs_extract_ax25_address(std::string& station, const uint8_t* address)
+{
+	char   buffer[9];
+	size_t length = 0;
+
+	for (size_t i = 0; (i < 6) && ((address[i] >> 1) != ' '); ++i)
+		buffer[length++] = (char)(address[i] >> 1);
+
+	if (uint8_t ssid = ((address[6] >> 1) & 0x0F))
+	{
+		buffer[length++] = '-';
+
+		if (ssid >= 10)
+		{
+			buffer[length++] = '1';
+
+			ssid -= 10;
+		}
+
+		buffer[length++] = '0' + ssid;
+	}
+
+	if (!aprs_validate_station(std::string_view(buffer, length)))
+		return false;
+
+	station.assign(buffer, length);
+
+	return true;
+}
+// decodes the address, control and protocol fields of a ui frame, digipeaters are added to path unless it is nullptr
+// shared with the duplicate filter of APRService.cpp
+// @return offset of the information field, 0 if buffer is not a ui frame
+size_t             aprs_extract_ax25_header(const uint8_t* buffer, size_t size, std::string& tocall, std::string& sender, aprs_path* path)
+{
+	// destination, source, control and protocol
+	if (!buffer || (size < 16))
+		return 0;
+
+	if (!aprs_extract_ax25_address(tocall, &buffer[0]) || !aprs_extract_ax25_address(sender, &buffer[7]))
+		return 0;
+
+	std::string station;
+	size_t      offset = 14;
+
+	for (bool is_last = buffer[13] & 0x01; !is_last; offset += 7)
+	{
+		if ((size - offset) < (7 + 2))
+			return 0;
+
+		if (!path)
+		{
+			if (!aprs_extract_ax25_address(station, &buffer[offset]))
+				return 0;
+		}
+		else if ((path->size == path->chunks.max_size()) || !aprs_extract_ax25_address(path->chunks_stations[path->size], &buffer[offset]))
+			return 0;
+		else
+		{
+			path->chunks[path->size].station  = path->chunks_stations[path->size].c_str();
+			path->chunks[path->size].repeated = buffer[offset + 6] & 0x80;
+
+			++path->size;
+		}
+
+		is_last = buffer[offset + 6] & 0x01;
+	}
+
+	// ui frame with no layer 3 protocol
+	if ((buffer[offset] != 0x03) || (buffer[offset + 1] != 0xF0))
+		return 0;
+
+	return offset + 2;
+}
 
 template<typename T>
 T                  aprs_decode_int_ex(std::string_view string, size_t max_length, char(*get_char)(size_t index, char value))
@@ -582,22 +900,54 @@ bool               aprs_decode_hex_8(uint8_t& value, char c1, char c2)
 
 	return true;
 }
+constexpr uint32_t APRS_BASE91_POWER[] = { 1, 91, 91 * 91, 91 * 91 * 91, 91 * 91 * 91 * 91 };
+
+// callers must validate digits
+constexpr uint16_t aprs_decode_base91_2(const char* string)
+{
+	return ((string[0] - 33) * APRS_BASE91_POWER[1]) + (string[1] - 33);
+}
+// callers must validate digits
+constexpr uint32_t aprs_decode_base91_4(const char* string)
+{
+	return ((string[0] - 33) * APRS_BASE91_POWER[3]) + ((string[1] - 33) * APRS_BASE91_POWER[2]) + ((string[2] - 33) * APRS_BASE91_POWER[1]) + (string[3] - 33);
+}
+// value must be less than 91^2
+constexpr void     aprs_encode_base91_2(char* string, uint32_t value)
+{
+	string[0] = (value / APRS_BASE91_POWER[1]) + 33;
+	string[1] = (value % APRS_BASE91_POWER[1]) + 33;
+}
+// value must be less than 91^4
+constexpr void     aprs_encode_base91_4(char* string, uint32_t value)
+{
+	string[0] = (value / APRS_BASE91_POWER[3]) + 33; value %= APRS_BASE91_POWER[3];
+	string[1] = (value / APRS_BASE91_POWER[2]) + 33; value %= APRS_BASE91_POWER[2];
+	string[2] = (value / APRS_BASE91_POWER[1]) + 33;
+	string[3] = (value % APRS_BASE91_POWER[1]) + 33;
+}
 template<typename T>
 bool               aprs_decode_base91(T& value, std::string_view string)
 {
-	value = 0;
+	if (!aprs_validate_base91(string))
+		return false;
 
-	for (size_t i = 0, j = string.length() - 1; i < string.length(); ++i, --j)
+	switch (string.length())
 	{
-		if (!aprs_validate_base91(string[i]))
-			return false;
+		case 2:
+			value = aprs_decode_base91_2(string.data());
+			return true;
 
-		if (j)
-			value += std::pow(91, j) * (string[i] - 33);
-		else
-			value += string[i] - 33;
+		case 4:
+			value = aprs_decode_base91_4(string.data());
+			return true;
 	}
 
+	value = 0;
+
+	for (auto c : string)
+		value = (value * 91) + (c - 33);
+
 	return true;
 }
 bool               aprs_decode_latitude(float& value, std::string_view string, char hemisphere)
@@ -814,93 +1164,70 @@ void               aprs_encode_time(aprs_time* time, std::stringstream& ss)
 	}
 }
 
-bool               aprs_decode_compressed_location(aprs_compressed_location& value, std::string_view string)
+// decodes count consecutive 13 byte blocks from string into values
+// @return number of blocks decoded before the first invalid block
+size_t             aprs_decode_compressed_locations(aprs_compressed_location* values, const char* string, size_t count)
 {
-	static auto string_is_valid = [](size_t index, char value)->bool
+	static constexpr auto is_digit_valid = [](char value)->bool
 	{
-		switch (index)
-		{
-			case 0:
-			case 9:
-				return true;
-
-			case 1:
-			case 2:
-			case 3:
-			case 4:
-			case 5:
-			case 6:
-			case 7:
-			case 8:
-				return (value >= '!') && (value <= '{');
-
-			case 10:
-			case 11:
-			case 12:
-				return ((value >= '!') && (value <= '{')) || (value == ' ');
-		}
-
-		return false;
+		return (value >= '!') && (value <= '{');
 	};
 
-	if ((string.length() != 13) || !aprs_validate_string(string, string_is_valid))
-		return false;
+	for (size_t i = 0; i < count; ++i, string += 13)
+	{
+		auto  cs        = &string[10];
+		auto  latitude  = &string[1];
+		auto  longitude = &string[5];
+		auto& value     = values[i];
 
-	auto cs        = &string[10];
-	auto type      = string[12] - 33;
-	auto latitude  = &string[1];
-	auto longitude = &string[5];
+		if (!is_digit_valid(latitude[0])  || !is_digit_valid(latitude[1])  || !is_digit_valid(latitude[2])  || !is_digit_valid(latitude[3]) ||
+			!is_digit_valid(longitude[0]) || !is_digit_valid(longitude[1]) || !is_digit_valid(longitude[2]) || !is_digit_valid(longitude[3]))
+			return i;
 
-	value.speed            = 0;
-	value.course           = 0;
-	value.altitude         = 0;
-	value.latitude         = 90 - (((latitude[0] - 33) * 753571) + ((latitude[1] - 33) * 8281) + ((latitude[2] - 33) * 91) + (latitude[3] - 33)) / 380926.0f;
-	value.longitude        = -180 + (((longitude[0] - 33) * 753571) + ((longitude[1] - 33) * 8281) + ((longitude[2] - 33) * 91) + (longitude[3] - 33)) / 190463.0f;
-	value.symbol_table     = string[0];
-	value.symbol_table_key = string[9];
+		if ((!is_digit_valid(cs[0]) && (cs[0] != ' ')) || (!is_digit_valid(cs[1]) && (cs[1] != ' ')) || (!is_digit_valid(cs[2]) && (cs[2] != ' ')))
+			return i;
 
-	if (cs[0] != ' ')
-	{
-		auto c = cs[0] - 33;
-		auto s = cs[1] - 33;
+		value.speed            = 0;
+		value.course           = 0;
+		value.altitude         = 0;
+		value.latitude         = 90 - aprs_decode_base91_4(latitude) / 380926.0f;
+		value.longitude        = -180 + aprs_decode_base91_4(longitude) / 190463.0f;
+		value.symbol_table     = string[0];
+		value.symbol_table_key = string[9];
 
-		if ((type & 0x10) == 0x10)
-			value.altitude = (c * 91) + s;
-		else if ((cs[0] >= '!') && (cs[0] <= 'z'))
+		if (cs[0] != ' ')
 		{
-			value.speed  = s;
-			value.course = c;
+			if (((cs[2] - 33) & 0x10) == 0x10)
+				value.altitude = aprs_decode_base91_2(cs);
+			else if (cs[0] <= 'z')
+			{
+				value.speed  = cs[1] - 33;
+				value.course = cs[0] - 33;
+			}
 		}
 	}
 
-	return true;
+	return count;
 }
-void               aprs_encode_compressed_location(const aprs_compressed_location& value, std::stringstream& ss)
+bool               aprs_decode_compressed_location(aprs_compressed_location& value, std::string_view string)
 {
-	static constexpr uint32_t divs[4]      = { 753571, 8281, 91, 1 };
-	int32_t                   latlong[]    = { (int32_t)(380926 * (90 - value.latitude)), (int32_t)(190463 * (180 + value.longitude)) };
-	char                      altitude[2]  = { (char)((value.altitude / 91) + 33), (char)((value.altitude % 91) + 33) };
-	char                      latitude[4]  = {};
-	char                      longitude[4] = {};
+	if (string.length() != 13)
+		return false;
 
-	for (int i = 0; i < 4; ++i)
-	{
-		latitude[i] = (latlong[0] / divs[i]) + 33;
-		latlong[0] %= divs[i];
-	}
+	return aprs_decode_compressed_locations(&value, string.data(), 1) == 1;
+}
+void               aprs_encode_compressed_location(const aprs_compressed_location& value, std::stringstream& ss)
+{
+	char string[13];
 
-	for (int i = 0; i < 4; ++i)
-	{
-		longitude[i] = (latlong[1] / divs[i]) + 33;
-		latlong[1]  %= divs[i];
-	}
+	string[0] = value.symbol_table;
+	aprs_encode_base91_4(&string[1], (uint32_t)(380926 * (90 - value.latitude)));
+	aprs_encode_base91_4(&string[5], (uint32_t)(190463 * (180 + value.longitude)));
+	string[9] = value.symbol_table_key;
+	aprs_encode_base91_2(&string[10], value.altitude);
+	string[12] = 0x51;
 
-	ss << value.symbol_table;
-	ss << latitude[0] << latitude[1] << latitude[2] << latitude[3];
-	ss << longitude[0] << longitude[1] << longitude[2] << longitude[3];
-	ss << value.symbol_table_key;
-	ss << altitude[0] << altitude[1];
-	ss << (uint8_t)0x51;
+	ss.write(string, sizeof(string));
 }
 
 void               aprs_packet_decode_comment_weather(aprs_packet* packet, std::string& string)
@@ -1248,7 +1575,7 @@ bool               aprs_packet_decode_mic_e(aprs_packet* packet, std::string& to
 		.mic_e_message    = (APRS_MIC_E_MESSAGES)(message & 0x7F)
 	};
 
-	if (!aprs_decode_base91(packet->extensions.altitude, packet->position->comment) || (comment[3] != '}'))
+	if ((packet->position->comment.length() < 4) || (comment[3] != '}') || !aprs_decode_base91(packet->extensions.altitude, std::string_view(comment, 3)))
 		packet->extensions.altitude = 0;
 	else
 	{
@@ -1284,11 +1611,11 @@ bool               aprs_packet_decode_mic_e(aprs_packet* packet, std::string& to
 }
 bool               aprs_packet_decode_mic_e(aprs_packet* packet)
 {
-	return aprs_packet_decode_mic_e(packet, packet->tocall, packet->content, true);
+	return aprs_packet_decode_mic_e(packet, packet->tocall, packet->content->value, true);
 }
 bool               aprs_packet_decode_mic_e_old(aprs_packet* packet)
 {
-	return aprs_packet_decode_mic_e(packet, packet->tocall, packet->content, false);
+	return aprs_packet_decode_mic_e(packet, packet->tocall, packet->content->value, false);
 }
 bool               aprs_packet_decode_raw_gps(aprs_packet* packet)
 {
@@ -1296,7 +1623,7 @@ bool               aprs_packet_decode_raw_gps(aprs_packet* packet)
 
 	aprs_regex_match_result match;
 
-	if (!aprs_regex_match(match, regex, packet->content))
+	if (!aprs_regex_match(match, regex, packet->content->value))
 		return false;
 
 	packet->type = APRS_PACKET_TYPE_GPS;
@@ -1311,7 +1638,7 @@ bool               aprs_packet_decode_item(aprs_packet* packet)
 
 	aprs_regex_match_result match;
 
-	if (aprs_regex_match(match, regex, packet->content))
+	if (aprs_regex_match(match, regex, packet->content->value))
 	{
 		auto&            name_match = match[1];
 		std::string_view name(name_match.first, name_match.length());
@@ -1353,7 +1680,7 @@ bool               aprs_packet_decode_item(aprs_packet* packet)
 		return true;
 	}
 
-	if (aprs_regex_match(match, regex_compressed, packet->content))
+	if (aprs_regex_match(match, regex_compressed, packet->content->value))
 	{
 		auto&                    name_match = match[1];
 		std::string_view         name(name_match.first, name_match.length());
@@ -1412,7 +1739,7 @@ bool               aprs_packet_decode_object(aprs_packet* packet)
 	aprs_time               time;
 	aprs_regex_match_result match;
 
-	if (aprs_regex_match(match, regex, packet->content))
+	if (aprs_regex_match(match, regex, packet->content->value))
 	{
 		auto&            name_match = match[1];
 		std::string_view name(name_match.first, name_match.length());
@@ -1457,7 +1784,7 @@ bool               aprs_packet_decode_object(aprs_packet* packet)
 		return true;
 	}
 
-	if (aprs_regex_match(match, regex_compressed, packet->content))
+	if (aprs_regex_match(match, regex_compressed, packet->content->value))
 	{
 		auto&                    name_match = match[1];
 		std::string_view         name(name_match.first, name_match.length());
@@ -1506,7 +1833,7 @@ bool               aprs_packet_decode_status(aprs_packet* packet)
 	aprs_time               time;
 	aprs_regex_match_result match;
 
-	if (aprs_regex_match(match, regex, packet->content))
+	if (aprs_regex_match(match, regex, packet->content->value))
 	{
 		packet->type   = APRS_PACKET_TYPE_STATUS;
 		packet->status = new aprs_packet_status
@@ -1518,7 +1845,7 @@ bool               aprs_packet_decode_status(aprs_packet* packet)
 		return true;
 	}
 
-	if (aprs_regex_match(match, regex_time, packet->content))
+	if (aprs_regex_match(match, regex_time, packet->content->value))
 	{
 		auto& time_match = match[1];
 
@@ -1675,10 +2002,10 @@ bool               aprs_packet_decode_message(aprs_packet* packet)
 
 	aprs_regex_match_result match;
 
-	if (aprs_regex_match(match, regex_telemetry, packet->content))
+	if (aprs_regex_match(match, regex_telemetry, packet->content->value))
 		return aprs_packet_decode_message_telemetry(packet, match);
 
-	if (!aprs_regex_match(match, regex, packet->content))
+	if (!aprs_regex_match(match, regex, packet->content->value))
 		return false;
 
 	std::string_view id;
@@ -1736,11 +2063,11 @@ bool               aprs_packet_decode_message(aprs_packet* packet)
 }
 bool               aprs_packet_decode_weather(aprs_packet* packet)
 {
-	if (packet->content.length() < 10)
+	if (packet->content->value.length() < 10)
 		return false;
 
 	aprs_time        time;
-	std::string_view time_string(packet->content.c_str() + 1, 8);
+	std::string_view time_string(packet->content->value.c_str() + 1, 8);
 
 	if (!aprs_decode_time(time, time_string, 0))
 		return false;
@@ -1782,7 +2109,7 @@ bool               aprs_packet_decode_weather(aprs_packet* packet)
 
 	char             key;
 	int              value;
-	std::string_view string(packet->content.c_str() + 9, packet->content.length() - 9);
+	std::string_view string(packet->content->value.c_str() + 9, packet->content->value.length() - 9);
 
 	while (decode_next_chunk(string, key, value))
 		switch (key)
@@ -1810,7 +2137,7 @@ bool               aprs_packet_decode_weather(aprs_packet* packet)
 }
 bool               aprs_packet_decode_weather_raw(aprs_packet* packet)
 {
-	switch (packet->content.front())
+	switch (packet->content->value.front())
 	{
 		case '!': // Ultimeter 2000
 		case '$': // Ultimeter 2000
@@ -1839,7 +2166,7 @@ bool               aprs_packet_decode_position(aprs_packet* packet, int flags)
 
 	aprs_regex_match_result match;
 
-	if (aprs_regex_match(match, regex, packet->content))
+	if (aprs_regex_match(match, regex, packet->content->value))
 	{
 		float latitude;
 		auto& latitude_match  = match[1];
@@ -1870,7 +2197,7 @@ bool               aprs_packet_decode_position(aprs_packet* packet, int flags)
 		return true;
 	}
 
-	if (aprs_regex_match(match, regex_time, packet->content))
+	if (aprs_regex_match(match, regex_time, packet->content->value))
 	{
 		aprs_time time;
 		auto&     time_match      = match[1];
@@ -1909,7 +2236,7 @@ bool               aprs_packet_decode_position(aprs_packet* packet, int flags)
 	}
 
 	// TODO: "260730 Power Supply = 14.0V" should not match..
-	if (aprs_regex_match(match, regex_compressed, packet->content))
+	if (aprs_regex_match(match, regex_compressed, packet->content->value))
 	{
 		aprs_compressed_location location;
 		auto&                    location_match = match[1];
@@ -1958,7 +2285,7 @@ bool               aprs_packet_decode_telemetry(aprs_packet* packet)
 
 	aprs_regex_match_result match;
 
-	if (!aprs_regex_match(match, regex, packet->content))
+	if (!aprs_regex_match(match, regex, packet->content->value))
 		return false;
 
 	auto&            analog_1_match = match[3];
@@ -2043,22 +2370,22 @@ bool               aprs_packet_decode_third_party(aprs_packet* packet)
 	packet->type        = APRS_PACKET_TYPE_THIRD_PARTY;
 	packet->third_party = new aprs_packet_third_party
 	{
-		.content = packet->content.substr(1)
+		.content = packet->content->value.substr(1)
 	};
 
 	return true;
 }
 bool               aprs_packet_decode_user_defined(aprs_packet* packet)
 {
-	if (packet->content.length() < 3)
+	if (packet->content->value.length() < 3)
 		return false;
 
 	packet->type         = APRS_PACKET_TYPE_USER_DEFINED;
 	packet->user_defined = new aprs_packet_user_defined
 	{
-		.id   = packet->content[1],
-		.type = packet->content[2],
-		.data = packet->content.substr(3)
+		.id   = packet->content->value[1],
+		.type = packet->content->value[2],
+		.data = packet->content->value.substr(3)
 	};
 
 	return true;
@@ -2095,7 +2422,7 @@ void               aprs_packet_encode_gps(aprs_packet* packet, std::stringstream
 }
 void               aprs_packet_encode_raw(aprs_packet* packet, std::stringstream& ss)
 {
-	ss << packet->content;
+	ss << packet->content->value;
 }
 void               aprs_packet_encode_item(aprs_packet* packet, std::stringstream& ss)
 {
@@ -2562,6 +2889,7 @@ struct aprs_path*                 APRSERVICE_CALL aprs_path_init_from_copy(struc
 
 		.string          = path->string,
 
+		.hash            = path->hash,
 		.reference_count = 1
 	};
 
@@ -2611,7 +2939,7 @@ struct aprs_path*                 APRSERVICE_CALL aprs_path_init_from_string(con
 }
 void                              APRSERVICE_CALL aprs_path_deinit(struct aprs_path* path)
 {
-	if (!--path->reference_count)
+	if (aprs_reference_count_release(path->reference_count))
 		delete path;
 }
 const struct aprs_path_node*      APRSERVICE_CALL aprs_path_get(struct aprs_path* path)
@@ -2635,7 +2963,7 @@ uint8_t                           APRSERVICE_CALL aprs_path_get_capacity(struct
 }
 size_t                            APRSERVICE_CALL aprs_path_get_reference_count(struct aprs_path* path)
 {
-	return path->reference_count;
+	return aprs_reference_count_get(path->reference_count);
 }
 bool                              APRSERVICE_CALL aprs_path_set(struct aprs_path* path, uint8_t index, const char* station, bool repeated)
 {
@@ -2648,6 +2976,7 @@ bool                              APRSERVICE_CALL aprs_path_set(struct aprs_path
 	if (!aprs_validate_station(station))
 		return false;
 
+	path->hash.store(0);
 	path->chunks_stations[index].assign(station);
 	path->chunks[index].station  = path->chunks_stations[index].c_str();
 	path->chunks[index].repeated = repeated;
@@ -2659,12 +2988,13 @@ bool                              APRSERVICE_CALL aprs_path_pop(struct aprs_path
 	if (path->size == 0)
 		return false;
 
+	--path->size;
+
+	path->hash.store(0);
 	path->chunks_stations[path->size].clear();
 	path->chunks[path->size].station  = nullptr;
 	path->chunks[path->size].repeated = false;
 
-	--path->size;
-
 	return true;
 }
 bool                              APRSERVICE_CALL aprs_path_push(struct aprs_path* path, const char* station, bool repeated)
@@ -2678,6 +3008,7 @@ bool                              APRSERVICE_CALL aprs_path_push(struct aprs_pat
 	if (path->size == path->chunks.max_size())
 		return false;
 
+	path->hash.store(0);
 	path->chunks_stations[path->size].assign(station);
 	path->chunks[path->size].station  = path->chunks_stations[path->size].c_str();
 	path->chunks[path->size].repeated = repeated;
@@ -2695,6 +3026,7 @@ void                              APRSERVICE_CALL aprs_path_clear(struct aprs_pa
 	}
 
 	path->size = 0;
+	path->hash.store(0);
 }
 bool                              APRSERVICE_CALL aprs_path_compare(struct aprs_path* path, struct aprs_path* path2)
 {
@@ -2704,17 +3036,39 @@ bool                              APRSERVICE_CALL aprs_path_compare(struct aprs_
 	if (path->size != path2->size)
 		return false;
 
+	if (aprs_path_hash(path) != aprs_path_hash(path2))
+		return false;
+
 	for (size_t i = 0; i < path->size; ++i)
 	{
-		if (!path->chunks[i].repeated != path2->chunks[i].repeated)
+		if (path->chunks[i].repeated != path2->chunks[i].repeated)
 			return false;
 
-		if (!path->chunks_stations[i].compare(path2->chunks_stations[i]))
+		if (path->chunks_stations[i] != path2->chunks_stations[i])
 			return false;
 	}
 
 	return true;
 }
+uint64_t                          APRSERVICE_CALL aprs_path_hash(struct aprs_path* path)
+{
+	auto hash = path->hash.load();
+
+	if (!hash)
+	{
+		hash = aprs_hash(APRS_HASH_SECRET[0], path->size);
+
+		for (size_t i = 0; i < path->size; ++i)
+		{
+			hash = aprs_hash(hash, path->chunks_stations[i]);
+			hash = aprs_hash(hash, path->chunks[i].repeated);
+		}
+
+		path->hash.store(hash = hash ? hash : 1);
+	}
+
+	return hash;
+}
 const char*                       APRSERVICE_CALL aprs_path_to_string(struct aprs_path* path)
 {
 	std::stringstream ss;
@@ -2741,7 +3095,7 @@ const char*                       APRSERVICE_CALL aprs_path_to_string(struct apr
 }
 void                              APRSERVICE_CALL aprs_path_add_reference(struct aprs_path* path)
 {
-	++path->reference_count;
+	aprs_reference_count_add(path->reference_count);
 }
 
 bool                              APRSERVICE_CALL aprs_time_type_is_valid(int value)
@@ -2922,280 +3276,383 @@ bool                              APRSERVICE_CALL aprs_time_compare(const struct
 	return true;
 }
 
-bool                                              aprs_packet_decode(aprs_packet* packet)
+template<typename T>
+void                                              aprs_packet_payload_share(T*& payload, T* source)
 {
-	if (auto content = aprs_packet_get_content(packet))
-		for (auto& decoder : aprs_packet_decoders)
-			if (decoder.ident == *content)
-				if (decoder.function(packet))
-					return true;
+	aprs_reference_count_add(source->reference_count);
 
-	return false;
+	payload = source;
 }
-bool                                              aprs_packet_encode(aprs_packet* packet, std::stringstream& ss)
+template<typename T>
+void                                              aprs_packet_payload_release(T* payload)
 {
-	if (auto type = aprs_packet_get_type(packet); type < APRS_PACKET_TYPES_COUNT)
+	if (aprs_reference_count_release(payload->reference_count))
+		delete payload;
+}
+template<typename T>
+void                                              aprs_packet_payload_detach(T*& payload)
+{
+	if (aprs_reference_count_get(payload->reference_count) > 1)
 	{
-		aprs_packet_encoders[type].function(packet, ss);
+		auto source = payload;
 
-		return true;
-	}
+		payload = new T(*source);
 
-	return false;
+		aprs_packet_payload_release(source);
+	}
 }
-
-struct aprs_packet*               APRSERVICE_CALL aprs_packet_init(const char* sender, const char* tocall, struct aprs_path* path)
+void                                              aprs_packet_payload_detach(aprs_packet_telemetry*& payload)
 {
-	if (!sender || !tocall || !path)
-		return nullptr;
-
-	if (!aprs_validate_station(sender))
-		return nullptr;
-
-	auto packet = new aprs_packet
+	if (aprs_reference_count_get(payload->reference_count) > 1)
 	{
-		.type            = APRS_PACKET_TYPE_RAW,
-		.path            = path,
-		.tocall          = tocall,
-		.sender          = sender,
-		.reference_count = 1
-	};
+		auto source = payload;
 
-	aprs_path_add_reference(path);
+		payload = new aprs_packet_telemetry(*source);
 
-	return packet;
+		aprs_packet_payload_release(source);
+
+		for (size_t i = 0; i < payload->eqns_count; ++i)
+			payload->eqns_c[i] = &payload->eqns[i];
+		for (size_t i = 0; i < payload->units_count; ++i)
+			payload->units_c[i] = payload->units[i].c_str();
+		for (size_t i = 0; i < payload->params_count; ++i)
+			payload->params_c[i] = payload->params[i].c_str();
+		for (size_t i = 0; i < payload->analog_u8.size(); ++i)
+			payload->analog_u8_c[i] = &payload->analog_u8[i];
+		for (size_t i = 0; i < payload->analog_float.size(); ++i)
+			payload->analog_float_c[i] = &payload->analog_float[i];
+	}
 }
-struct aprs_packet*                               aprs_packet_init_ex(const char* sender, const char* tocall, struct aprs_path* path, enum APRS_PACKET_TYPES type)
+void                                              aprs_packet_payload_share(aprs_packet* packet, aprs_packet* source)
 {
-	if (!sender || !tocall || !path)
-		return nullptr;
-
-	auto packet = new aprs_packet
+	switch (packet->type)
 	{
-		.type            = type,
-		.path            = path,
-		.tocall          = tocall,
-		.sender          = sender,
-		.reference_count = 1
-	};
+		case APRS_PACKET_TYPE_GPS:
+			aprs_packet_payload_share(packet->gps, source->gps);
+			break;
 
-	aprs_path_add_reference(path);
+		case APRS_PACKET_TYPE_RAW:
+			break;
 
-	return packet;
-}
-struct aprs_packet*               APRSERVICE_CALL aprs_packet_init_from_copy(struct aprs_packet* packet)
-{
-	auto p = new aprs_packet
-	{
-		.type            = packet->type,
-		.path            = aprs_path_init_from_copy(packet->path),
-		.igate           = packet->igate,
-		.tocall          = packet->tocall,
-		.sender          = packet->sender,
-		.content         = packet->content,
-		.qconstruct      = packet->qconstruct,
-		.extensions      = packet->extensions,
+		case APRS_PACKET_TYPE_ITEM:
+			aprs_packet_payload_share(packet->item, source->item);
+			break;
 
-		.string          = packet->string,
+		case APRS_PACKET_TYPE_TEST:
+			// TODO: share test
+			break;
 
-		.reference_count = 1
-	};
+		case APRS_PACKET_TYPE_QUERY:
+			// TODO: share query
+			break;
+
+		case APRS_PACKET_TYPE_OBJECT:
+			aprs_packet_payload_share(packet->object, source->object);
+			break;
+
+		case APRS_PACKET_TYPE_STATUS:
+			aprs_packet_payload_share(packet->status, source->status);
+			break;
+
+		case APRS_PACKET_TYPE_MESSAGE:
+			aprs_packet_payload_share(packet->message, source->message);
+			break;
+
+		case APRS_PACKET_TYPE_WEATHER:
+			aprs_packet_payload_share(packet->weather, source->weather);
+			break;
+
+		case APRS_PACKET_TYPE_POSITION:
+			aprs_packet_payload_share(packet->position, source->position);
+			break;
+
+		case APRS_PACKET_TYPE_TELEMETRY:
+			aprs_packet_payload_share(packet->telemetry, source->telemetry);
+			break;
+
+		case APRS_PACKET_TYPE_MAP_FEATURE:
+			// TODO: share map feature
+			break;
+
+		case APRS_PACKET_TYPE_GRID_BEACON:
+			// TODO: share grid beacon
+			break;
+
+		case APRS_PACKET_TYPE_THIRD_PARTY:
+			aprs_packet_payload_share(packet->third_party, source->third_party);
+			break;
+
+		case APRS_PACKET_TYPE_MICROFINDER:
+			// TODO: share microfinder
+			break;
+
+		case APRS_PACKET_TYPE_USER_DEFINED:
+			aprs_packet_payload_share(packet->user_defined, source->user_defined);
+			break;
 
+		case APRS_PACKET_TYPE_SHELTER_TIME:
+			// TODO: share shelter time
+			break;
+
+		case APRS_PACKET_TYPE_STATION_CAPABILITIES:
+			// TODO: share station capabilities
+			break;
+
+		case APRS_PACKET_TYPE_MAIDENHEAD_GRID_BEACON:
+			// TODO: share maidenhead grid beacon
+			break;
+	}
+}
+void                                              aprs_packet_payload_detach(aprs_packet* packet)
+{
 	switch (packet->type)
 	{
 		case APRS_PACKET_TYPE_GPS:
-			p->gps = new aprs_packet_gps
-			{
-				.nmea    = packet->gps->nmea,
-				.comment = packet->gps->comment
-			};
+			aprs_packet_payload_detach(packet->gps);
 			break;
 
 		case APRS_PACKET_TYPE_RAW:
 			break;
 
 		case APRS_PACKET_TYPE_ITEM:
-			p->item = new aprs_packet_item
-			{
-				.is_alive         = packet->item->is_alive,
-				.is_compressed    = packet->item->is_compressed,
-
-				.time             = packet->item->time,
-
-				.name             = packet->item->name,
-				.comment          = packet->item->comment,
-
-				.latitude         = packet->item->latitude,
-				.longitude        = packet->item->longitude,
-
-				.symbol_table     = packet->item->symbol_table,
-				.symbol_table_key = packet->item->symbol_table_key
-			};
+			aprs_packet_payload_detach(packet->item);
 			break;
 
 		case APRS_PACKET_TYPE_TEST:
-			// TODO: copy test
+			// TODO: detach test
 			break;
 
 		case APRS_PACKET_TYPE_QUERY:
-			// TODO: copy query
+			// TODO: detach query
 			break;
 
 		case APRS_PACKET_TYPE_OBJECT:
-			p->object = new aprs_packet_object
-			{
-				.is_alive         = packet->object->is_alive,
-				.is_compressed    = packet->object->is_compressed,
-
-				.time             = packet->object->time,
+			aprs_packet_payload_detach(packet->object);
+			break;
 
-				.name             = packet->object->name,
-				.comment          = packet->object->comment,
+		case APRS_PACKET_TYPE_STATUS:
+			aprs_packet_payload_detach(packet->status);
+			break;
 
-				.latitude         = packet->object->latitude,
-				.longitude        = packet->object->longitude,
+		case APRS_PACKET_TYPE_MESSAGE:
+			aprs_packet_payload_detach(packet->message);
+			break;
 
-				.symbol_table     = packet->object->symbol_table,
-				.symbol_table_key = packet->object->symbol_table_key
-			};
+		case APRS_PACKET_TYPE_WEATHER:
+			aprs_packet_payload_detach(packet->weather);
 			break;
 
-		case APRS_PACKET_TYPE_STATUS:
-			p->status = new aprs_packet_status
-			{
-				.is_time_set = packet->status->is_time_set,
+		case APRS_PACKET_TYPE_POSITION:
+			aprs_packet_payload_detach(packet->position);
+			break;
 
-				.time        = packet->status->time,
-				.message     = packet->status->message
-			};
+		case APRS_PACKET_TYPE_TELEMETRY:
+			aprs_packet_payload_detach(packet->telemetry);
 			break;
 
-		case APRS_PACKET_TYPE_MESSAGE:
-			p->message = new aprs_packet_message
-			{
-				.id          = packet->message->id,
-				.type        = packet->message->type,
-				.content     = packet->message->content,
-				.destination = packet->message->destination
-			};
+		case APRS_PACKET_TYPE_MAP_FEATURE:
+			// TODO: detach map feature
 			break;
 
-		case APRS_PACKET_TYPE_WEATHER:
-			p->weather = new aprs_packet_weather
-			{
-				.time                    = packet->weather->time,
+		case APRS_PACKET_TYPE_GRID_BEACON:
+			// TODO: detach grid beacon
+			break;
 
-				.wind_speed              = packet->weather->wind_speed,
-				.wind_speed_gust         = packet->weather->wind_speed_gust,
-				.wind_direction          = packet->weather->wind_direction,
+		case APRS_PACKET_TYPE_THIRD_PARTY:
+			aprs_packet_payload_detach(packet->third_party);
+			break;
 
-				.rainfall_last_hour      = packet->weather->rainfall_last_hour,
-				.rainfall_last_24_hours  = packet->weather->rainfall_last_24_hours,
-				.rainfall_since_midnight = packet->weather->rainfall_since_midnight,
+		case APRS_PACKET_TYPE_MICROFINDER:
+			// TODO: detach microfinder
+			break;
 
-				.humidity                = packet->weather->humidity,
-				.temperature             = packet->weather->temperature,
-				.barometric_pressure     = packet->weather->barometric_pressure,
+		case APRS_PACKET_TYPE_USER_DEFINED:
+			aprs_packet_payload_detach(packet->user_defined);
+			break;
 
-				.type                    = packet->weather->type,
-				.software                = packet->weather->software
-			};
+		case APRS_PACKET_TYPE_SHELTER_TIME:
+			// TODO: detach shelter time
 			break;
 
-		case APRS_PACKET_TYPE_POSITION:
-			p->position = new aprs_packet_position
-			{
-				.flags                    = packet->position->flags,
+		case APRS_PACKET_TYPE_STATION_CAPABILITIES:
+			// TODO: detach station capabilities
+			break;
 
-				.time                     = packet->position->time,
+		case APRS_PACKET_TYPE_MAIDENHEAD_GRID_BEACON:
+			// TODO: detach maidenhead grid beacon
+			break;
+	}
+}
+void                                              aprs_packet_payload_release(aprs_packet* packet)
+{
+	switch (packet->type)
+	{
+		case APRS_PACKET_TYPE_GPS:
+			aprs_packet_payload_release(packet->gps);
+			break;
 
-				.latitude                 = packet->position->latitude,
-				.longitude                = packet->position->longitude,
+		case APRS_PACKET_TYPE_RAW:
+			break;
 
-				.comment                  = packet->position->comment,
+		case APRS_PACKET_TYPE_ITEM:
+			aprs_packet_payload_release(packet->item);
+			break;
 
-				.symbol_table             = packet->position->symbol_table,
-				.symbol_table_key         = packet->position->symbol_table_key,
+		case APRS_PACKET_TYPE_TEST:
+			// TODO: release test
+			break;
 
-				.mic_e_message            = packet->position->mic_e_message,
-				.mic_e_telemetry          = packet->position->mic_e_telemetry,
-				.mic_e_telemetry_channels = packet->position->mic_e_telemetry_channels
-			};
-		break;
+		case APRS_PACKET_TYPE_QUERY:
+			// TODO: release query
+			break;
 
-		case APRS_PACKET_TYPE_TELEMETRY:
-			p->telemetry = new aprs_packet_telemetry
-			{
-				.type           = packet->telemetry->type,
+		case APRS_PACKET_TYPE_OBJECT:
+			aprs_packet_payload_release(packet->object);
+			break;
 
-				.eqns           = packet->telemetry->eqns,
-				.eqns_count     = packet->telemetry->eqns_count,
+		case APRS_PACKET_TYPE_STATUS:
+			aprs_packet_payload_release(packet->status);
+			break;
 
-				.units          = packet->telemetry->units,
-				.units_count    = packet->telemetry->units_count,
+		case APRS_PACKET_TYPE_MESSAGE:
+			aprs_packet_payload_release(packet->message);
+			break;
 
-				.params         = packet->telemetry->params,
-				.params_count   = packet->telemetry->params_count,
+		case APRS_PACKET_TYPE_WEATHER:
+			aprs_packet_payload_release(packet->weather);
+			break;
 
-				.analog_u8      = packet->telemetry->analog_u8,
-				.analog_float   = packet->telemetry->analog_float,
-				.digital        = packet->telemetry->digital,
-				.sequence       = packet->telemetry->sequence,
-				.comment        = packet->telemetry->comment
-			};
+		case APRS_PACKET_TYPE_POSITION:
+			aprs_packet_payload_release(packet->position);
+			break;
 
-			for (size_t i = 0; i < p->telemetry->eqns_count; ++i)
-				p->telemetry->eqns_c[i] = &p->telemetry->eqns[i];
-			for (size_t i = 0; i < p->telemetry->units_count; ++i)
-				p->telemetry->units_c[i] = p->telemetry->units[i].c_str();
-			for (size_t i = 0; i < p->telemetry->params_count; ++i)
-				p->telemetry->params_c[i] = p->telemetry->params[i].c_str();
-			for (size_t i = 0; i < p->telemetry->analog_u8.size(); ++i)
-				p->telemetry->analog_u8_c[i] = &p->telemetry->analog_u8[i];
-			for (size_t i = 0; i < p->telemetry->analog_float.size(); ++i)
-				p->telemetry->analog_float_c[i] = &p->telemetry->analog_float[i];
+		case APRS_PACKET_TYPE_TELEMETRY:
+			aprs_packet_payload_release(packet->telemetry);
 			break;
 
 		case APRS_PACKET_TYPE_MAP_FEATURE:
-			// TODO: copy map feature
+			// TODO: release map feature
 			break;
 
 		case APRS_PACKET_TYPE_GRID_BEACON:
-			// TODO: copy grid beacon
+			// TODO: release grid beacon
 			break;
 
 		case APRS_PACKET_TYPE_THIRD_PARTY:
-			p->third_party = new aprs_packet_third_party
-			{
-				.content = packet->third_party->content
-			};
+			aprs_packet_payload_release(packet->third_party);
 			break;
 
 		case APRS_PACKET_TYPE_MICROFINDER:
-			// TODO: copy microfinder
+			// TODO: release microfinder
 			break;
 
 		case APRS_PACKET_TYPE_USER_DEFINED:
-			p->user_defined = new aprs_packet_user_defined
-			{
-				.id   = packet->user_defined->id,
-				.type = packet->user_defined->type,
-				.data = packet->user_defined->data
-			};
+			aprs_packet_payload_release(packet->user_defined);
 			break;
 
 		case APRS_PACKET_TYPE_SHELTER_TIME:
-			// TODO: copy shelter time
+			// TODO: release shelter time
 			break;
 
 		case APRS_PACKET_TYPE_STATION_CAPABILITIES:
-			// TODO: copy station capabilities
+			// TODO: release station capabilities
 			break;
 
 		case APRS_PACKET_TYPE_MAIDENHEAD_GRID_BEACON:
-			// TODO: copy maidenhead grid beacon
+			// TODO: release maidenhead grid beacon
 			break;
 	}
+}
+// must be called before any field of a packet is changed
+// the payload may be shared with copies of this packet and is detached here
+void                                              aprs_packet_modify(aprs_packet* packet)
+{
+	packet->hash.store(0);
+
+	aprs_packet_payload_detach(packet);
+}
+bool                                              aprs_packet_decode(aprs_packet* packet)
+{
+	if (auto content = aprs_packet_get_content(packet))
+		for (auto& decoder : aprs_packet_decoders)
+			if (decoder.ident == *content)
+				if (decoder.function(packet))
+					return true;
+
+	return false;
+}
+bool                                              aprs_packet_encode(aprs_packet* packet, std::stringstream& ss)
+{
+	if (auto type = aprs_packet_get_type(packet); type < APRS_PACKET_TYPES_COUNT)
+	{
+		aprs_packet_encoders[type].function(packet, ss);
+
+		return true;
+	}
+
+	return false;
+}
+
+struct aprs_packet*               APRSERVICE_CALL aprs_packet_init(const char* sender, const char* tocall, struct aprs_path* path)
+{
+	if (!sender || !tocall || !path)
+		return nullptr;
+
+	if (!aprs_validate_station(sender))
+		return nullptr;
+
+	auto packet = new aprs_packet
+	{
+		.type            = APRS_PACKET_TYPE_RAW,
+		.path            = path,
+		.tocall          = tocall,
+		.sender          = sender,
+		.content         = new aprs_packet_content { .reference_count = 1 },
+		.reference_count = 1
+	};
+
+	aprs_path_add_reference(path);
+
+	return packet;
+}
+struct aprs_packet*                               aprs_packet_init_ex(const char* sender, const char* tocall, struct aprs_path* path, enum APRS_PACKET_TYPES type)
+{
+	if (!sender || !tocall || !path)
+		return nullptr;
+
+	auto packet = new aprs_packet
+	{
+		.type            = type,
+		.path            = path,
+		.tocall          = tocall,
+		.sender          = sender,
+		.content         = new aprs_packet_content { .reference_count = 1 },
+		.reference_count = 1
+	};
+
+	aprs_path_add_reference(path);
+
+	return packet;
+}
+struct aprs_packet*               APRSERVICE_CALL aprs_packet_init_from_copy(struct aprs_packet* packet)
+{
+	auto p = new aprs_packet
+	{
+		.type            = packet->type,
+		.path            = aprs_path_init_from_copy(packet->path),
+		.igate           = packet->igate,
+		.tocall          = packet->tocall,
+		.sender          = packet->sender,
+		.qconstruct      = packet->qconstruct,
+		.extensions      = packet->extensions,
+
+		.hash            = packet->hash,
+		.reference_count = 1
+	};
+
+	// the path is small and aprs_packet_get_path lets it be changed, so each copy gets its own
+	aprs_packet_payload_share(p->content, packet->content);
+	aprs_packet_payload_share(p, packet);
 
 	return p;
 }
@@ -3235,7 +3692,7 @@ struct aprs_packet*               APRSERVICE_CALL aprs_packet_init_from_string(c
 		.igate           = std::move(path_q_igate[1]),
 		.tocall          = match[2].str(),
 		.sender          = match[1].str(),
-		.content         = match[4].str(),
+		.content         = new aprs_packet_content { .value = match[4].str(), .reference_count = 1 },
 		.qconstruct      = std::move(path_q_igate[0]),
 		.reference_count = 1
 	};
@@ -3254,89 +3711,48 @@ struct aprs_packet*               APRSERVICE_CALL aprs_packet_init_from_string(c
 
 	return packet;
 }
-void                              APRSERVICE_CALL aprs_packet_deinit(struct aprs_packet* packet)
+struct aprs_packet*               APRSERVICE_CALL aprs_packet_init_from_ax25(const uint8_t* buffer, size_t size)
 {
-	if (!--packet->reference_count)
-	{
-		aprs_path_deinit(packet->path);
-
-		switch (packet->type)
-		{
-			case APRS_PACKET_TYPE_GPS:
-				delete packet->gps;
-				break;
-
-			case APRS_PACKET_TYPE_RAW:
-				break;
-
-			case APRS_PACKET_TYPE_ITEM:
-				delete packet->item;
-				break;
-
-			case APRS_PACKET_TYPE_TEST:
-				// TODO: deinit test
-				break;
-
-			case APRS_PACKET_TYPE_QUERY:
-				// TODO: deinit query
-				break;
-
-			case APRS_PACKET_TYPE_OBJECT:
-				delete packet->object;
-				break;
-
-			case APRS_PACKET_TYPE_STATUS:
-				delete packet->status;
-				break;
-
-			case APRS_PACKET_TYPE_MESSAGE:
-				delete packet->message;
-				break;
-
-			case APRS_PACKET_TYPE_WEATHER:
-				delete packet->weather;
-				break;
-
-			case APRS_PACKET_TYPE_POSITION:
-				delete packet->position;
-			break;
-
-			case APRS_PACKET_TYPE_TELEMETRY:
-				delete packet->telemetry;
-				break;
+	std::string tocall;
+	std::string sender;
 
-			case APRS_PACKET_TYPE_MAP_FEATURE:
-				// TODO: deinit map feature
-				break;
+	auto   path   = aprs_path_init();
+	size_t offset = aprs_extract_ax25_header(buffer, size, tocall, sender, path);
 
-			case APRS_PACKET_TYPE_GRID_BEACON:
-				// TODO: deinit grid beacon
-				break;
+	if (!offset)
+	{
+		aprs_path_deinit(path);
 
-			case APRS_PACKET_TYPE_THIRD_PARTY:
-				delete packet->third_party;
-				break;
+		return nullptr;
+	}
 
-			case APRS_PACKET_TYPE_MICROFINDER:
-				// TODO: deinit microfinder
-				break;
+	size_t content_length = size - offset;
 
-			case APRS_PACKET_TYPE_USER_DEFINED:
-				delete packet->user_defined;
-				break;
+	// some tnc append a carriage return to the information field
+	if (content_length && (buffer[size - 1] == '\r'))
+		--content_length;
 
-			case APRS_PACKET_TYPE_SHELTER_TIME:
-				// TODO: deinit shelter time
-				break;
+	auto packet = new aprs_packet
+	{
+		.path            = path,
+		.tocall          = std::move(tocall),
+		.sender          = std::move(sender),
+		.content         = new aprs_packet_content { .value = std::string((const char*)&buffer[offset], content_length), .reference_count = 1 },
+		.reference_count = 1
+	};
 
-			case APRS_PACKET_TYPE_STATION_CAPABILITIES:
-				// TODO: deinit station capabilities
-				break;
+	if (!aprs_packet_decode(packet))
+		packet->type = APRS_PACKET_TYPE_RAW;
 
-			case APRS_PACKET_TYPE_MAIDENHEAD_GRID_BEACON:
-				// TODO: deinit maidenhead grid beacon
-				break;
-		}
+	return packet;
+}
+void                              APRSERVICE_CALL aprs_packet_deinit(struct aprs_packet* packet)
+{
+	if (aprs_reference_count_release(packet->reference_count))
+	{
+		aprs_path_deinit(packet->path);
+		aprs_packet_payload_release(packet);
+		aprs_packet_payload_release(packet->content);
 
 		delete packet;
 	}
@@ -3367,17 +3783,19 @@ const char*                       APRSERVICE_CALL aprs_packet_get_sender(struct
 }
 const char*                       APRSERVICE_CALL aprs_packet_get_content(struct aprs_packet* packet)
 {
-	return packet->content.c_str();
+	return packet->content->value.c_str();
 }
 size_t                            APRSERVICE_CALL aprs_packet_get_reference_count(struct aprs_packet* packet)
 {
-	return packet->reference_count;
+	return aprs_reference_count_get(packet->reference_count);
 }
 bool                              APRSERVICE_CALL aprs_packet_set_path(struct aprs_packet* packet, struct aprs_path* value)
 {
 	if (!value)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	aprs_path_deinit(packet->path);
 
 	packet->path = value;
@@ -3394,6 +3812,8 @@ bool                              APRSERVICE_CALL aprs_packet_set_tocall(struct
 	if (!aprs_validate_name(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->tocall.assign(value);
 
 	return true;
@@ -3406,6 +3826,8 @@ bool                              APRSERVICE_CALL aprs_packet_set_sender(struct
 	if (!aprs_validate_station(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->sender.assign(value);
 
 	return true;
@@ -3418,9 +3840,13 @@ bool                              APRSERVICE_CALL aprs_packet_set_content(struct
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_RAW)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (auto length = aprs_string_length(value); length && (length <= 256))
 	{
-		packet->content.assign(value, length);
+		aprs_packet_payload_detach(packet->content);
+
+		packet->content->value.assign(value, length);
 
 		return true;
 	}
@@ -3435,12 +3861,15 @@ bool                              APRSERVICE_CALL aprs_packet_compare(struct apr
 	if (packet->type != packet2->type)
 		return false;
 
+	if (aprs_packet_hash(packet) != aprs_packet_hash(packet2))
+		return false;
+
 	if (packet->type                       != packet2->type)                       return false;
 	if (!aprs_path_compare(packet->path, packet2->path))                           return false;
 	if (packet->igate                      != packet2->igate)                      return false;
 	if (packet->tocall                     != packet2->tocall)                     return false;
 	if (packet->sender                     != packet2->sender)                     return false;
-	if (packet->content                    != packet2->content)                    return false;
+	if (packet->content->value             != packet2->content->value)             return false;
 	if (packet->qconstruct                 != packet2->qconstruct)                 return false;
 	if (packet->extensions.speed           != packet2->extensions.speed)           return false;
 	if (packet->extensions.course          != packet2->extensions.course)          return false;
@@ -3595,20 +4024,181 @@ bool                              APRSERVICE_CALL aprs_packet_compare(struct apr
 
 	return true;
 }
-const char*                       APRSERVICE_CALL aprs_packet_to_string(struct aprs_packet* packet)
+uint64_t                          APRSERVICE_CALL aprs_packet_hash(struct aprs_packet* packet)
 {
+	auto hash = packet->hash.load();
+
+	if (!hash)
 	{
-		std::stringstream ss;
+		hash = aprs_hash(APRS_HASH_SECRET[0], packet->type);
 
-		if (!aprs_packet_encode(packet, ss))
-			return nullptr;
+		hash = aprs_hash(hash, packet->igate);
+		hash = aprs_hash(hash, packet->tocall);
+		hash = aprs_hash(hash, packet->sender);
+		hash = aprs_hash(hash, packet->content->value);
+		hash = aprs_hash(hash, packet->qconstruct);
+		hash = aprs_hash(hash, packet->extensions.speed);
+		hash = aprs_hash(hash, packet->extensions.course);
+		hash = aprs_hash(hash, packet->extensions.altitude);
+		hash = aprs_hash(hash, packet->extensions.dfs.strength);
+		hash = aprs_hash(hash, packet->extensions.dfs.height);
+		hash = aprs_hash(hash, packet->extensions.dfs.gain);
+		hash = aprs_hash(hash, packet->extensions.dfs.directivity);
+		hash = aprs_hash(hash, packet->extensions.phg.power);
+		hash = aprs_hash(hash, packet->extensions.phg.height);
+		hash = aprs_hash(hash, packet->extensions.phg.gain);
+		hash = aprs_hash(hash, packet->extensions.phg.directivity);
+		hash = aprs_hash(hash, packet->extensions.rng.miles);
+
+		switch (packet->type)
+		{
+			case APRS_PACKET_TYPE_GPS:
+				hash = aprs_hash(hash, packet->gps->nmea);
+				hash = aprs_hash(hash, packet->gps->comment);
+				break;
+
+			case APRS_PACKET_TYPE_ITEM:
+				hash = aprs_hash(hash, packet->item->is_alive);
+				hash = aprs_hash(hash, packet->item->is_compressed);
+				hash = aprs_hash(hash, packet->item->name);
+				hash = aprs_hash(hash, packet->item->comment);
+				hash = aprs_hash(hash, packet->item->latitude);
+				hash = aprs_hash(hash, packet->item->longitude);
+				hash = aprs_hash(hash, packet->item->symbol_table);
+				hash = aprs_hash(hash, packet->item->symbol_table_key);
+				break;
+
+			case APRS_PACKET_TYPE_OBJECT:
+				hash = aprs_hash(hash, packet->object->is_alive);
+				hash = aprs_hash(hash, packet->object->is_compressed);
+				hash = aprs_hash(hash, packet->object->time);
+				hash = aprs_hash(hash, packet->object->name);
+				hash = aprs_hash(hash, packet->object->comment);
+				hash = aprs_hash(hash, packet->object->latitude);
+				hash = aprs_hash(hash, packet->object->longitude);
+				hash = aprs_hash(hash, packet->object->symbol_table);
+				hash = aprs_hash(hash, packet->object->symbol_table_key);
+				break;
+
+			case APRS_PACKET_TYPE_STATUS:
+				hash = aprs_hash(hash, packet->status->is_time_set);
+				hash = aprs_hash(hash, packet->status->time);
+				hash = aprs_hash(hash, packet->status->message);
+				break;
 
-		packet->content = ss.str();
+			case APRS_PACKET_TYPE_MESSAGE:
+				hash = aprs_hash(hash, packet->message->id);
+				hash = aprs_hash(hash, packet->message->type);
+				hash = aprs_hash(hash, packet->message->content);
+				hash = aprs_hash(hash, packet->message->destination);
+				break;
+
+			case APRS_PACKET_TYPE_WEATHER:
+				hash = aprs_hash(hash, packet->weather->time);
+				hash = aprs_hash(hash, packet->weather->wind_speed);
+				hash = aprs_hash(hash, packet->weather->wind_speed_gust);
+				hash = aprs_hash(hash, packet->weather->wind_direction);
+				hash = aprs_hash(hash, packet->weather->rainfall_last_hour);
+				hash = aprs_hash(hash, packet->weather->rainfall_last_24_hours);
+				hash = aprs_hash(hash, packet->weather->rainfall_since_midnight);
+				hash = aprs_hash(hash, packet->weather->humidity);
+				hash = aprs_hash(hash, packet->weather->temperature);
+				hash = aprs_hash(hash, packet->weather->barometric_pressure);
+				hash = aprs_hash(hash, packet->weather->type);
+				hash = aprs_hash(hash, packet->weather->software);
+				break;
+
+			case APRS_PACKET_TYPE_POSITION:
+				hash = aprs_hash(hash, packet->position->flags);
+				hash = aprs_hash(hash, packet->position->time);
+				hash = aprs_hash(hash, packet->position->latitude);
+				hash = aprs_hash(hash, packet->position->longitude);
+				hash = aprs_hash(hash, packet->position->comment);
+				hash = aprs_hash(hash, packet->position->symbol_table);
+				hash = aprs_hash(hash, packet->position->symbol_table_key);
+				hash = aprs_hash(hash, packet->position->mic_e_message);
+				hash = aprs_hash(packet->position->mic_e_telemetry.data(), packet->position->mic_e_telemetry.size(), hash);
+				hash = aprs_hash(hash, packet->position->mic_e_telemetry_channels);
+				break;
+
+			case APRS_PACKET_TYPE_TELEMETRY:
+				hash = aprs_hash(hash, packet->telemetry->type);
+				hash = aprs_hash(hash, packet->telemetry->eqns_count);
+				hash = aprs_hash(hash, packet->telemetry->units_count);
+				hash = aprs_hash(hash, packet->telemetry->params_count);
+				hash = aprs_hash(packet->telemetry->analog_u8.data(), packet->telemetry->analog_u8.size(), hash);
+				hash = aprs_hash(hash, packet->telemetry->digital);
+				hash = aprs_hash(hash, packet->telemetry->sequence);
+				hash = aprs_hash(hash, packet->telemetry->comment);
+
+				for (auto& unit : packet->telemetry->units)
+					hash = aprs_hash(hash, unit);
+
+				for (auto& param : packet->telemetry->params)
+					hash = aprs_hash(hash, param);
+
+				for (auto analog : packet->telemetry->analog_float)
+					hash = aprs_hash(hash, analog);
+
+				for (size_t i = 0; i < packet->telemetry->eqns_count; ++i)
+				{
+					hash = aprs_hash(hash, packet->telemetry->eqns[i].a);
+					hash = aprs_hash(hash, packet->telemetry->eqns[i].b);
+					hash = aprs_hash(hash, packet->telemetry->eqns[i].c);
+				}
+				break;
+
+			case APRS_PACKET_TYPE_THIRD_PARTY:
+				hash = aprs_hash(hash, packet->third_party->content);
+				break;
+
+			case APRS_PACKET_TYPE_USER_DEFINED:
+				hash = aprs_hash(hash, packet->user_defined->id);
+				hash = aprs_hash(hash, packet->user_defined->type);
+				hash = aprs_hash(hash, packet->user_defined->data);
+				break;
+
+			default:
+				break;
+		}
+
+		packet->hash.store(hash = hash ? hash : 1);
 	}
 
+	return aprs_hash(hash, aprs_path_hash(packet->path));
+}
+const char*                       APRSERVICE_CALL aprs_packet_content_to_string(struct aprs_packet* packet)
+{
+	std::stringstream ss;
+
+	if (!aprs_packet_encode(packet, ss))
+		return nullptr;
+
+	if (auto content = ss.str(); packet->content->value != content)
+	{
+		// the content is rendered from the payload, only the content is detached so copies still share the payload
+		packet->hash.store(0);
+
+		aprs_packet_payload_detach(packet->content);
+
+		packet->content->value = std::move(content);
+	}
+
+	return packet->content->value.c_str();
+}
+const char*                       APRSERVICE_CALL aprs_packet_to_string(struct aprs_packet* packet)
+{
+	if (!aprs_packet_content_to_string(packet))
+		return nullptr;
+
 	{
 		std::stringstream ss;
-		ss << aprs_packet_get_sender(packet) << '>' << aprs_packet_get_tocall(packet) << ',' << aprs_path_to_string(packet->path) << ':' << packet->content;
+		ss << aprs_packet_get_sender(packet) << '>' << aprs_packet_get_tocall(packet);
+
+		if (packet->path->size)
+			ss << ',' << aprs_path_to_string(packet->path);
+
+		ss << ':' << packet->content->value;
 
 		packet->string = ss.str();
 	}
@@ -3617,7 +4207,7 @@ const char*                       APRSERVICE_CALL aprs_packet_to_string(struct a
 }
 void                              APRSERVICE_CALL aprs_packet_add_reference(struct aprs_packet* packet)
 {
-	++packet->reference_count;
+	aprs_reference_count_add(packet->reference_count);
 }
 
 struct aprs_packet*               APRSERVICE_CALL aprs_packet_gps_init(const char* sender, const char* tocall, struct aprs_path* path, const char* nmea)
@@ -3663,6 +4253,8 @@ bool                              APRSERVICE_CALL aprs_packet_gps_set_nmea(struc
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_GPS)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 		packet->gps->nmea.clear();
 	else
@@ -3675,6 +4267,8 @@ bool                              APRSERVICE_CALL aprs_packet_gps_set_comment(st
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_GPS)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 		packet->gps->comment.clear();
 	else
@@ -3793,6 +4387,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_alive(str
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_ITEM)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->item->is_alive = value;
 
 	return true;
@@ -3802,6 +4398,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_compresse
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_ITEM)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->item->is_compressed = value;
 
 	return true;
@@ -3817,6 +4415,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_name(stru
 	if (!aprs_validate_name(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->item->name.assign(value);
 
 	return true;
@@ -3826,6 +4426,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_comment(s
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_ITEM)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 	{
 		packet->item->comment.clear();
@@ -3846,6 +4448,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_speed(str
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_ITEM)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->extensions.speed = value;
 
 	return true;
@@ -3858,6 +4462,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_course(st
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_ITEM)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->extensions.course = value;
 
 	return true;
@@ -3867,6 +4473,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_altitude(
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_ITEM)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->extensions.altitude = value;
 
 	return true;
@@ -3876,6 +4484,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_latitude(
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_ITEM)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->item->latitude = value;
 
 	return true;
@@ -3885,6 +4495,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_longitude
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_ITEM)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->item->longitude = value;
 
 	return true;
@@ -3897,6 +4509,8 @@ bool                              APRSERVICE_CALL aprs_packet_item_set_symbol(st
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_ITEM)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->item->symbol_table     = table;
 	packet->item->symbol_table_key = key;
 
@@ -4035,6 +4649,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_time(st
 	if (!aprs_validate_time(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->object->time = *value;
 
 	return true;
@@ -4044,6 +4660,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_alive(s
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_OBJECT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->object->is_alive = value;
 
 	return true;
@@ -4053,6 +4671,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_compres
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_OBJECT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->object->is_compressed = value;
 
 	return true;
@@ -4068,6 +4688,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_name(st
 	if (!aprs_validate_name(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->object->name.assign(value);
 
 	return true;
@@ -4077,6 +4699,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_comment
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_OBJECT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 	{
 		packet->object->comment.clear();
@@ -4097,6 +4721,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_speed(s
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_OBJECT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->extensions.speed = value;
 
 	return true;
@@ -4109,6 +4735,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_course(
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_OBJECT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->extensions.course = value;
 
 	return true;
@@ -4118,6 +4746,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_altitud
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_OBJECT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->extensions.altitude = value;
 
 	return true;
@@ -4127,6 +4757,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_latitud
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_OBJECT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->object->latitude = value;
 
 	return true;
@@ -4136,6 +4768,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_longitu
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_OBJECT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->object->longitude = value;
 
 	return true;
@@ -4148,6 +4782,8 @@ bool                              APRSERVICE_CALL aprs_packet_object_set_symbol(
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_OBJECT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->object->symbol_table     = table;
 	packet->object->symbol_table_key = key;
 
@@ -4180,7 +4816,7 @@ struct aprs_packet*               APRSERVICE_CALL aprs_packet_status_init(const
 
 	return nullptr;
 }
-struct aprs_time*                 APRSERVICE_CALL aprs_packet_status_get_time(struct aprs_packet* packet)
+const struct aprs_time*           APRSERVICE_CALL aprs_packet_status_get_time(struct aprs_packet* packet)
 {
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_STATUS)
 		return nullptr;
@@ -4202,6 +4838,8 @@ bool                              APRSERVICE_CALL aprs_packet_status_set_time(st
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_STATUS)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 	{
 		packet->status->is_time_set = false;
@@ -4230,6 +4868,8 @@ bool                              APRSERVICE_CALL aprs_packet_status_set_message
 	if (!aprs_validate_status(value, packet->status->is_time_set ? 55 : 62))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 		packet->status->message.clear();
 	else
@@ -4368,6 +5008,8 @@ bool                              APRSERVICE_CALL aprs_packet_message_set_id(str
 	if (aprs_packet_message_get_type(packet) == APRS_MESSAGE_TYPE_BULLETIN)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 	{
 		if (aprs_packet_message_get_type(packet) != APRS_MESSAGE_TYPE_MESSAGE)
@@ -4399,6 +5041,8 @@ bool                              APRSERVICE_CALL aprs_packet_message_set_type(s
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_MESSAGE)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	switch (value)
 	{
 		case APRS_MESSAGE_TYPE_ACK:
@@ -4432,6 +5076,8 @@ bool                              APRSERVICE_CALL aprs_packet_message_set_conten
 			return false;
 	}
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 	{
 		packet->message->content.clear();
@@ -4459,6 +5105,8 @@ bool                              APRSERVICE_CALL aprs_packet_message_set_destin
 	if (!aprs_validate_name(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->message->destination.assign(value);
 
 	return true;
@@ -4596,6 +5244,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_time(s
 	if (!aprs_validate_time(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->time = *value;
 
 	return true;
@@ -4608,6 +5258,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_wind_s
 	if (value > 9999)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->wind_speed = value;
 
 	return true;
@@ -4620,6 +5272,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_wind_s
 	if (value > 9999)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->wind_speed_gust = value;
 
 	return true;
@@ -4632,6 +5286,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_wind_d
 	if (value > 359)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->wind_direction = value;
 
 	return true;
@@ -4644,6 +5300,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_rainfa
 	if (value > 9999)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->rainfall_last_hour = value;
 
 	return true;
@@ -4656,6 +5314,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_rainfa
 	if (value > 9999)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->rainfall_last_24_hours = value;
 
 	return true;
@@ -4668,6 +5328,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_rainfa
 	if (value > 9999)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->rainfall_since_midnight = value;
 
 	return true;
@@ -4680,6 +5342,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_humidi
 	if (value > 100)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->humidity = value;
 
 	return true;
@@ -4695,6 +5359,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_temper
 	if ((value < 0) && (value < -999))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->temperature = value;
 
 	return true;
@@ -4707,6 +5373,8 @@ bool                              APRSERVICE_CALL aprs_packet_weather_set_barome
 	if (value > 99999)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->weather->barometric_pressure = value;
 
 	return true;
@@ -4881,6 +5549,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_set_time(
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 	{
 		packet->position->flags &= ~APRS_POSITION_FLAG_TIME;
@@ -4906,6 +5576,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_set_comme
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 	{
 		packet->position->comment.clear();
@@ -4926,6 +5598,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_set_speed
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->extensions.speed = value;
 
 	return true;
@@ -4938,6 +5612,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_set_cours
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->extensions.course = value;
 
 	return true;
@@ -4947,6 +5623,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_set_altit
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->extensions.altitude = value;
 
 	return true;
@@ -4956,6 +5634,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_set_latit
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->position->latitude = value;
 
 	return true;
@@ -4965,6 +5645,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_set_longi
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->position->longitude = value;
 
 	return true;
@@ -4977,6 +5659,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_set_symbo
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->position->symbol_table     = table;
 	packet->position->symbol_table_key = key;
 
@@ -4998,6 +5682,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_set_mic_e
 	if (!aprs_packet_position_is_mic_e(packet))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->position->mic_e_message = value;
 
 	return true;
@@ -5007,6 +5693,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_enable_mi
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (value)
 	{
 		packet->position->flags |= APRS_POSITION_FLAG_MIC_E;
@@ -5022,6 +5710,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_enable_me
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_POSITION)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (value)
 		packet->position->flags |= APRS_POSITION_FLAG_MESSAGING_ENABLED;
 	else
@@ -5037,6 +5727,8 @@ bool                              APRSERVICE_CALL aprs_packet_position_enable_co
 	if (aprs_packet_position_is_mic_e(packet))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (value)
 		packet->position->flags |= APRS_POSITION_FLAG_COMPRESSED;
 	else
@@ -5292,6 +5984,8 @@ bool                              APRSERVICE_CALL aprs_packet_telemetry_set_bits
 	if (aprs_packet_telemetry_get_type(packet) != APRS_TELEMETRY_TYPE_BITS)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->telemetry->digital = value;
 
 	return true;
@@ -5307,6 +6001,8 @@ bool                              APRSERVICE_CALL aprs_packet_telemetry_set_anal
 	if (aprs_packet_telemetry_get_type(packet) != APRS_TELEMETRY_TYPE_U8)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->telemetry->analog_u8[index] = value;
 
 	return true;
@@ -5322,6 +6018,8 @@ bool                              APRSERVICE_CALL aprs_packet_telemetry_set_anal
 	if (aprs_packet_telemetry_get_type(packet) != APRS_TELEMETRY_TYPE_FLOAT)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->telemetry->analog_float[index] = value;
 
 	return true;
@@ -5331,6 +6029,8 @@ bool                              APRSERVICE_CALL aprs_packet_telemetry_set_digi
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_TELEMETRY)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	switch (aprs_packet_telemetry_get_type(packet))
 	{
 		case APRS_TELEMETRY_TYPE_U8:
@@ -5349,6 +6049,8 @@ bool                              APRSERVICE_CALL aprs_packet_telemetry_set_sequ
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_TELEMETRY)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	switch (aprs_packet_telemetry_get_type(packet))
 	{
 		case APRS_TELEMETRY_TYPE_U8:
@@ -5364,6 +6066,8 @@ bool                              APRSERVICE_CALL aprs_packet_telemetry_set_comm
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_TELEMETRY)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	switch (aprs_packet_telemetry_get_type(packet))
 	{
 		case APRS_TELEMETRY_TYPE_U8:
@@ -5439,6 +6143,8 @@ bool                              APRSERVICE_CALL aprs_packet_user_defined_set_i
 	if (!isprint(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->user_defined->id = value;
 
 	return true;
@@ -5451,6 +6157,8 @@ bool                              APRSERVICE_CALL aprs_packet_user_defined_set_t
 	if (!isprint(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->user_defined->type = value;
 
 	return true;
@@ -5466,6 +6174,8 @@ bool                              APRSERVICE_CALL aprs_packet_user_defined_set_d
 	if (!aprs_validate_user_defined_data(value))
 		return false;
 
+	aprs_packet_modify(packet);
+
 	packet->user_defined->data.assign(value);
 
 	return true;
@@ -5494,6 +6204,8 @@ bool                              APRSERVICE_CALL aprs_packet_third_party_set_co
 	if (aprs_packet_get_type(packet) != APRS_PACKET_TYPE_THIRD_PARTY)
 		return false;
 
+	aprs_packet_modify(packet);
+
 	if (!value)
 		packet->third_party->content.clear();
 	else
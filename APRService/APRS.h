@@ -147,6 +147,7 @@ APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_path_po
 APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_path_push(struct aprs_path* path, const char* station, bool repeated);
 APRSERVICE_EXPORT void                              APRSERVICE_CALL aprs_path_clear(struct aprs_path* path);
 APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_path_compare(struct aprs_path* path, struct aprs_path* path2);
+APRSERVICE_EXPORT uint64_t                          APRSERVICE_CALL aprs_path_hash(struct aprs_path* path);
 APRSERVICE_EXPORT const char*                       APRSERVICE_CALL aprs_path_to_string(struct aprs_path* path);
 APRSERVICE_EXPORT void                              APRSERVICE_CALL aprs_path_add_reference(struct aprs_path* path);
 
@@ -166,6 +167,7 @@ APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_time_co
 APRSERVICE_EXPORT struct aprs_packet*               APRSERVICE_CALL aprs_packet_init(const char* sender, const char* tocall, struct aprs_path* path);
 APRSERVICE_EXPORT struct aprs_packet*               APRSERVICE_CALL aprs_packet_init_from_copy(struct aprs_packet* packet);
 APRSERVICE_EXPORT struct aprs_packet*               APRSERVICE_CALL aprs_packet_init_from_string(const char* string);
+APRSERVICE_EXPORT struct aprs_packet*               APRSERVICE_CALL aprs_packet_init_from_ax25(const uint8_t* buffer, size_t size);
 APRSERVICE_EXPORT void                              APRSERVICE_CALL aprs_packet_deinit(struct aprs_packet* packet);
 APRSERVICE_EXPORT const char*                       APRSERVICE_CALL aprs_packet_get_q(struct aprs_packet* packet);
 APRSERVICE_EXPORT enum APRS_PACKET_TYPES            APRSERVICE_CALL aprs_packet_get_type(struct aprs_packet* packet);
@@ -180,6 +182,8 @@ APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_packet_
 APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_packet_set_sender(struct aprs_packet* packet, const char* value);
 APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_packet_set_content(struct aprs_packet* packet, const char* value);
 APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_packet_compare(struct aprs_packet* packet, struct aprs_packet* packet2);
+APRSERVICE_EXPORT uint64_t                          APRSERVICE_CALL aprs_packet_hash(struct aprs_packet* packet);
+APRSERVICE_EXPORT const char*                       APRSERVICE_CALL aprs_packet_content_to_string(struct aprs_packet* packet);
 APRSERVICE_EXPORT const char*                       APRSERVICE_CALL aprs_packet_to_string(struct aprs_packet* packet);
 APRSERVICE_EXPORT void                              APRSERVICE_CALL aprs_packet_add_reference(struct aprs_packet* packet);
 
@@ -242,7 +246,7 @@ APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_packet_
 APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_packet_object_set_symbol_table_key(struct aprs_packet* packet, char value);
 
 APRSERVICE_EXPORT struct aprs_packet*               APRSERVICE_CALL aprs_packet_status_init(const char* sender, const char* tocall, struct aprs_path* path, const char* message);
-APRSERVICE_EXPORT struct aprs_time*                 APRSERVICE_CALL aprs_packet_status_get_time(struct aprs_packet* packet);
+APRSERVICE_EXPORT const struct aprs_time*           APRSERVICE_CALL aprs_packet_status_get_time(struct aprs_packet* packet);
 APRSERVICE_EXPORT const char*                       APRSERVICE_CALL aprs_packet_status_get_message(struct aprs_packet* packet);
 APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_packet_status_set_time(struct aprs_packet* packet, struct aprs_time* value);
 APRSERVICE_EXPORT bool                              APRSERVICE_CALL aprs_packet_status_set_message(struct aprs_packet* packet, const char* value);
@@ -4,7 +4,7 @@
 #include <list>
 #include <array>
 #include <ctime>
-#include <queue>
+#include <deque>
 #include <regex>
 #include <chrono>
 #include <string>
@@ -14,6 +14,7 @@
 #include <sstream>
 #include <utility>
 #include <iostream>
+#include <algorithm>
 #include <unordered_map>
 
 #if defined(APRSERVICE_UNIX)
@@ -28,17 +29,59 @@
 	#include <sys/ioctl.h>
 	#include <sys/types.h>
 	#include <sys/socket.h>
+	#include <sys/uio.h>
 
 	#include <netinet/tcp.h>
 
 	#include <strings.h>
 
+	#if defined(__linux__)
+		#define APRSERVICE_LOOP_EPOLL
+
+		#include <sys/epoll.h>
+
+		#if defined(APRSERVICE_IO_URING)
+			#define APRSERVICE_LOOP_IO_URING
+
+			#include <sys/mman.h>
+			#include <sys/syscall.h>
+
+			#include <linux/io_uring.h>
+		#endif
+	#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+		#define APRSERVICE_LOOP_KQUEUE
+
+		#include <sys/event.h>
+	#endif
+
 	#define stricmp strcasecmp
 #elif defined(APRSERVICE_WIN32)
 	#include <WS2tcpip.h>
 	#include <MSWSock.h>
 #endif
 
+constexpr size_t APRSERVICE_CONNECTION_TX_BATCH_SIZE       = 64;
+// number of times a priority can be passed over before it is sent ahead of higher priorities
+constexpr size_t APRSERVICE_CONNECTION_TX_STARVATION_LIMIT = 8;
+// milliseconds of airtime a tnc can be handed back to back after the channel was idle
+constexpr size_t APRSERVICE_CONNECTION_TX_AIRTIME_BURST    = 2000;
+// largest ax.25 ui frame, 10 addresses, control, protocol and 256 bytes of information
+constexpr size_t APRSERVICE_CONNECTION_KISS_FRAME_SIZE     = 330;
+
+// milliseconds between the first announcements after a change, doubled after each one until it reaches the announce period
+constexpr size_t APRSERVICE_ANNOUNCER_INTERVAL             = 8000;
+
+constexpr size_t APRSERVICE_TASK_WHEEL_LEVELS              = 4;
+constexpr size_t APRSERVICE_TASK_WHEEL_SLOT_BITS           = 8;
+constexpr size_t APRSERVICE_TASK_WHEEL_SLOTS               = 1 << APRSERVICE_TASK_WHEEL_SLOT_BITS;
+
+constexpr size_t APRSERVICE_LOOP_EVENT_COUNT               = 256;
+constexpr size_t APRSERVICE_LOOP_IO_URING_SQ_SIZE          = 256;
+constexpr size_t APRSERVICE_LOOP_IO_URING_CQ_SIZE          = 4096;
+// provided to the kernel for multishot receives, shared by every socket in a loop
+constexpr size_t APRSERVICE_LOOP_IO_URING_BUFFER_SIZE      = 4096;
+constexpr size_t APRSERVICE_LOOP_IO_URING_BUFFER_COUNT     = 256;
+
 enum KISS_TNC_COMMANDS : uint8_t
 {
 	// The following bytes should be transmitted by the TNC.
@@ -79,6 +122,17 @@ enum KISS_TNC_SPECIAL_CHARACTERS : uint8_t
 	KISS_TNC_SPECIAL_CHARACTER_TRANSPOSED_FRAME_ESCAPE = 0xDD
 };
 
+enum KISS_TNC_DEFRAMER_STATES : uint8_t
+{
+	// Waiting for the first frame end.
+	KISS_TNC_DEFRAMER_STATE_SYNC,
+	// Waiting for the command byte, repeated frame ends are skipped.
+	KISS_TNC_DEFRAMER_STATE_COMMAND,
+	KISS_TNC_DEFRAMER_STATE_DATA,
+	// The previous byte was a frame escape.
+	KISS_TNC_DEFRAMER_STATE_ESCAPE
+};
+
 enum APRSERVICE_AUTH_STATES
 {
 	APRSERVICE_AUTH_STATE_NONE,
@@ -110,68 +164,175 @@ struct aprservice_connection_buffer
 {
 	std::string value;
 	size_t      offset;
+	uint32_t    airtime;
+	// a pending buffer with the same key is replaced instead of queued again
+	std::string key;
+};
+// bytes in [read, write) are buffered, bytes in [read, scan) were searched for a line ending
+struct aprservice_connection_rx_buffer
+{
+	std::vector<char> data;
+	size_t            read;
+	size_t            scan;
+	size_t            write;
+};
+struct aprservice_connection_rx_queue_entry
+{
+	size_t offset;
+	size_t length;
+};
+// lines are stored back to back and null terminated, entries before front were read
+struct aprservice_connection_rx_queue
+{
+	std::vector<char>                                 data;
+	size_t                                            size;
+	std::vector<aprservice_connection_rx_queue_entry> entries;
+	size_t                                            front;
+};
+struct aprservice_connection_kiss_deframer
+{
+	uint8_t              state;
+	uint8_t              command;
+	std::vector<uint8_t> frame;
 };
 struct aprservice_connection
 {
-	aprservice*                              service;
+	aprservice*                                                    service;
 
-	bool                                     is_open;
+	bool                                                           is_open;
 
-	aprservice_connection_auth               auth;
-	int                                      type;
+	aprservice_connection_auth                                     auth;
+	int                                                            type;
 
 #if defined(APRSERVICE_UNIX)
-	int                                      serial;
-	int                                      socket;
+	int                                                            serial;
+	int                                                            socket;
 #elif defined(APRSERVICE_WIN32)
-	HANDLE                                   serial;
-	SOCKET                                   socket;
-	WSADATA                                  winsock;
+	HANDLE                                                         serial;
+	SOCKET                                                         socket;
+	WSADATA                                                        winsock;
 #endif
 
-	uint32_t                                 io_time;
+	uint64_t                                                       io_time;
+
+	aprservice_connection_rx_queue                                 rx_queue;
+	aprservice_connection_rx_buffer                                rx_buffer;
+	aprservice_connection_kiss_deframer                            kiss_deframer;
+	std::vector<uint8_t>                                           kiss_tx_frame;
+
+	std::deque<aprservice_connection_buffer>                       tx_queue;
+	// moved to tx_queue by priority once it is empty
+	std::deque<aprservice_connection_buffer>                       tx_pending[APRSERVICE_PRIORITIES_COUNT];
+	size_t                                                         tx_pending_size;
+	size_t                                                         tx_pending_skips[APRSERVICE_PRIORITIES_COUNT];
+	std::unordered_map<std::string, aprservice_connection_buffer*> tx_pending_index;
+	// milliseconds
+	uint64_t                                                       tx_pending_airtime;
+	// hundredths of a millisecond, refilled by the duty cycle
+	int64_t                                                        tx_airtime_tokens;
+	uint64_t                                                       tx_airtime_time;
+
+	uint32_t                                                       device_speed;
+	std::string                                                    host_or_device;
+	std::uint16_t                                                  port, passcode;
+};
+
+struct aprservice_duplicate_filter_entry
+{
+	uint64_t hash;
+	uint32_t time;
+};
+struct aprservice_duplicate_filter
+{
+	bool                                           is_enabled;
 
-	std::queue<std::string>                  rx_queue;
-	std::string                              rx_buffer;
-	std::array<char, 128>                    rx_buffer_tmp;
+	uint32_t                                       window;
+	uint64_t                                       drop_count;
 
-	std::queue<aprservice_connection_buffer> tx_queue;
+	// entries kept by a rehash, the oldest are evicted beyond this
+	size_t                                         max_size;
 
-	uint32_t                                 device_speed;
-	std::string                              host_or_device;
-	std::uint16_t                            port, passcode;
+	size_t                                         size;
+	std::vector<aprservice_duplicate_filter_entry> entries;
 };
 
 struct aprservice_message_callback_context
 {
-	std::string                 id;
-	std::string                 station;
-	uint32_t                    timeout;
+	std::string                 key;
+	size_t                      heap_index;
+	uint64_t                    timeout;
 	aprservice_message_callback callback;
 	void*                       callback_param;
+
+	// encoded for the connection it was first sent on
+	std::string                 line;
+	aprservice_task*            task;
+	uint8_t                     attempts;
+};
+// heap is a min-heap ordered by timeout, index is keyed by station and id
+struct aprservice_message_callback_queue
+{
+	std::vector<aprservice_message_callback_context*>                          heap;
+	std::unordered_multimap<std::string, aprservice_message_callback_context*> index;
+};
+
+struct aprservice_announcer
+{
+	aprservice_task* task;
+
+	// milliseconds, 0 if never announced
+	uint64_t         time;
+	uint32_t         interval;
+	// offsets steady announcements within the announce period
+	uint32_t         sequence;
 };
 
 struct aprservice_item
 {
-	aprservice*  service;
+	aprservice*          service;
 
-	aprs_packet* packet;
+	aprs_packet*         packet;
+	aprservice_announcer announcer;
 };
 
+// circular and doubly linked, an empty list points to itself
+struct aprservice_task_link
+{
+	aprservice_task_link* prev;
+	aprservice_task_link* next;
+};
 struct aprservice_task
 {
+	// must be first
+	aprservice_task_link    link;
+
 	aprservice*             service;
 
-	uint32_t                seconds;
+	bool                    is_running;
+	bool                    is_canceled;
+	// scheduled by aprservice_task_schedule_ms, rescheduled from milliseconds instead of seconds
+	bool                    is_milliseconds;
+
+	uint64_t                time;
+	// wider than aprservice_task_information::milliseconds so tasks scheduled in seconds do not wrap
+	uint64_t                milliseconds;
 	aprservice_task_handler handler;
 	void*                   handler_param;
 };
+// ticks are milliseconds, slots on each level span APRSERVICE_TASK_WHEEL_SLOTS times the ticks of the level below
+struct aprservice_task_wheel
+{
+	uint64_t             time;
+	size_t               size;
+	aprservice_task_link slots[APRSERVICE_TASK_WHEEL_LEVELS][APRSERVICE_TASK_WHEEL_SLOTS];
+};
 
 struct aprservice_object
 {
-	aprservice*  service;
+	aprservice*          service;
 
-	aprs_packet* packet;
+	aprs_packet*         packet;
+	aprservice_announcer announcer;
 };
 
 struct aprservice_command
@@ -188,33 +349,161 @@ struct aprservice_command
 	void*                             handler_param;
 };
 
+struct aprservice_loop_entry;
+#if defined(APRSERVICE_LOOP_IO_URING)
+struct aprservice_loop_io_uring;
+struct aprservice_loop_io_uring_watch;
+#endif
+
 struct aprservice
 {
 	bool                                                                            is_monitoring;
+	bool                                                                            is_command_case_folding;
 
-	std::string                                                                     line;
 	int64_t                                                                         time;
 	int                                                                             time_type;
 
 	aprs_path*                                                                      path;
 	const std::string                                                               station;
 	aprs_packet*                                                                    position;
+	std::vector<uint8_t>                                                            ax25_header;
+	uint64_t                                                                        ax25_header_path_hash;
 	aprservice_connection*                                                          connection;
 	uint32_t                                                                        connection_timeout;
+	uint32_t                                                                        kiss_baud_rate;
+	uint8_t                                                                         kiss_duty_cycle;
+	size_t                                                                          receive_buffer_size;
+	uint64_t                                                                        receive_packet_count;
+	uint64_t                                                                        receive_syscall_count;
+	aprservice_duplicate_filter                                                     duplicate_filter;
 
 	std::list<aprservice_item>                                                      items;
-	std::map<uint64_t, std::list<aprservice_task*>>                                 tasks;
+	// shared by items and objects
+	uint32_t                                                                        announce_period;
+	uint32_t                                                                        announce_sequence;
+	aprservice_task_wheel                                                           tasks;
 	aprservice_event                                                                events[APRSERVICE_EVENTS_COUNT + 1];
 	std::list<aprservice_object>                                                    objects;
-	std::list<aprservice_command>                                                   commands;
+	// keyed by lower case name, names that only differ by case share a bucket
+	std::unordered_multimap<std::string, aprservice_command>                        commands;
 
 	std::string                                                                     command_prefix;
 
 	uint32_t                                                                        message_count;
-	std::list<aprservice_message_callback_context*>                                 message_callbacks;
-	std::unordered_map<std::string, std::list<aprservice_message_callback_context>> message_callbacks_index;
+	aprservice_message_callback_queue                                               message_callbacks;
+	uint8_t                                                                         message_retry_count;
+	uint32_t                                                                        message_retry_interval;
+	// keyed by sender and id of messages received with an id
+	aprservice_duplicate_filter                                                     message_filter;
 
 	uint16_t                                                                        telemetry_count;
+
+	// nullptr if not added to a loop
+	aprservice_loop_entry*                                                          loop_entry;
+};
+
+struct aprservice_loop_entry
+{
+	aprservice_loop*                                          loop;
+	// nullptr once removed
+	aprservice*                                               service;
+
+	// waiting for aprservice_loop_update
+	bool                                                      is_pending;
+	// waiting for aprservice_loop_dispatch
+	bool                                                      is_ready;
+	bool                                                      is_readable;
+	bool                                                      is_writable;
+
+	int                                                       fd;
+	bool                                                      fd_write;
+
+	std::multimap<uint64_t, aprservice_loop_entry*>::iterator deadline;
+
+#if defined(APRSERVICE_LOOP_IO_URING)
+	aprservice_loop_io_uring_watch*                           io_uring_watch;
+#endif
+};
+#if defined(APRSERVICE_LOOP_IO_URING)
+enum APRSERVICE_LOOP_IO_URING_OPS : uint64_t
+{
+	// completions of cancel requests are ignored
+	APRSERVICE_LOOP_IO_URING_OP_CANCEL,
+	// multishot recv on sockets, multishot poll on serial devices
+	APRSERVICE_LOOP_IO_URING_OP_READ,
+	APRSERVICE_LOOP_IO_URING_OP_WRITE,
+
+	// stored in the low bits of user_data
+	APRSERVICE_LOOP_IO_URING_OP_MASK = 7
+};
+// a provided buffer filled by the kernel, handed back once it was copied out by aprservice_connection_read
+struct aprservice_loop_io_uring_rx
+{
+	uint16_t id;
+	uint32_t offset;
+	uint32_t size;
+};
+struct aprservice_loop_io_uring_watch
+{
+	aprservice_loop_io_uring*                           io_uring;
+	// nullptr once unwatched, erased when nothing is left in flight
+	aprservice_loop_entry*                              entry;
+	std::list<aprservice_loop_io_uring_watch>::iterator it;
+
+	int                                                 fd;
+	bool                                                is_socket;
+	bool                                                is_reading;
+	bool                                                is_writing;
+	// received eof or an error
+	bool                                                is_closed;
+
+	// received but not yet read by aprservice_connection_read
+	std::deque<aprservice_loop_io_uring_rx>             rx;
+};
+struct aprservice_loop_io_uring
+{
+	int                                                 fd;
+
+	void*                                               ring;
+	size_t                                              ring_size;
+
+	io_uring_sqe*                                       sqes;
+	size_t                                              sqes_size;
+	unsigned*                                           sq_head;
+	unsigned*                                           sq_tail;
+	unsigned*                                           sq_mask;
+	unsigned                                            sq_entries;
+	// prepared since the last io_uring_enter
+	unsigned                                            sq_pending;
+
+	io_uring_cqe*                                       cqes;
+	unsigned*                                           cq_head;
+	unsigned*                                           cq_tail;
+	unsigned*                                           cq_mask;
+
+	io_uring_buf_ring*                                  buffers_ring;
+	uint16_t                                            buffers_tail;
+	std::vector<char>                                   buffers;
+
+	std::list<aprservice_loop_io_uring_watch>           watches;
+};
+#endif
+struct aprservice_loop
+{
+	bool                                            is_polling;
+
+	// epoll or kqueue, -1 if io_uring is used instead
+	int                                             fd;
+#if defined(APRSERVICE_LOOP_IO_URING)
+	aprservice_loop_io_uring*                       io_uring;
+#endif
+
+	std::list<aprservice_loop_entry>                entries;
+	size_t                                          entries_removed;
+	std::vector<aprservice_loop_entry*>             ready;
+	std::vector<aprservice_loop_entry*>             pending;
+	// milliseconds since epoch of the steady clock
+	std::multimap<uint64_t, aprservice_loop_entry*> deadlines;
 };
 
 template<APRSERVICE_EVENTS EVENT>
@@ -326,1796 +615,3398 @@ bool                                       aprservice_connection_auth_from_strin
 	return true;
 }
 
-aprservice_connection*                     aprservice_connection_init(aprservice* service, int type, const char* host_or_device, uint16_t port, uint32_t speed, uint16_t passcode);
-void                                       aprservice_connection_deinit(aprservice_connection* connection);
-bool                                       aprservice_connection_is_open(aprservice_connection* connection);
-bool                                       aprservice_connection_open(aprservice_connection* connection);
-void                                       aprservice_connection_close(aprservice_connection* connection);
-// @return false on connection closed
-bool                                       aprservice_connection_poll(aprservice_connection* connection);
-// @return 0 on disconnect
-// @return -1 on would block
-int                                        aprservice_connection_read(aprservice_connection* connection, void* buffer, size_t size, size_t* number_of_bytes_received);
-// @return 0 on disconnect
-// @return -1 on would block
-int                                        aprservice_connection_write(aprservice_connection* connection, const void* buffer, size_t size, size_t* number_of_bytes_sent);
-bool                                       aprservice_connection_read_string(aprservice_connection* connection, std::string& value);
-// @return false on connection closed
-bool                                       aprservice_connection_write_packet(aprservice_connection* connection, aprs_packet* value);
-// @return false on connection closed
-bool                                       aprservice_connection_write_aprs_is(aprservice_connection* connection, std::string&& value);
-
-aprservice_connection*                     aprservice_connection_init(aprservice* service, int type, const char* host_or_device, uint16_t port, uint32_t speed, uint16_t passcode)
+// sender and tocall are hashed, the path is not (each igate and digipeater adds to it)
+uint64_t                                   aprservice_duplicate_filter_hash(std::string_view sender, std::string_view tocall, std::string_view content)
 {
-	auto connection = new aprservice_connection
-	{
-		.service        = service,
-
-		.is_open        = false,
+	while (!content.empty() && ((content.back() == ' ') || (content.back() == '\r') || (content.back() == '\n')))
+		content.remove_suffix(1);
 
-		.type           = type,
+	uint64_t hash = 0xCBF29CE484222325;
 
-		.io_time        = aprservice_get_time(service),
+	for (auto c : sender)
+		hash = (hash ^ (uint8_t)c) * 0x100000001B3;
 
-		.device_speed   = speed,
-		.host_or_device = host_or_device,
-		.port           = port,
-		.passcode       = passcode
-	};
+	hash = (hash ^ (uint8_t)'>') * 0x100000001B3;
 
-#if defined(APRSERVICE_WIN32)
-	if (auto error = WSAStartup(MAKEWORD(2, 2), &connection->winsock))
-	{
-		aprservice_log_error(WSAStartup, error);
+	for (auto c : tocall)
+		hash = (hash ^ (uint8_t)c) * 0x100000001B3;
 
-		delete connection;
+	hash = (hash ^ (uint8_t)':') * 0x100000001B3;
 
-		return nullptr;
-	}
-#endif
+	for (auto c : content)
+		hash = (hash ^ (uint8_t)c) * 0x100000001B3;
 
-	return connection;
+	return hash ? hash : 1;
 }
-void                                       aprservice_connection_deinit(aprservice_connection* connection)
+void                                       aprservice_duplicate_filter_rehash(aprservice_duplicate_filter* filter, uint32_t time)
 {
-	if (aprservice_connection_is_open(connection))
-		aprservice_connection_close(connection);
+	std::vector<aprservice_duplicate_filter_entry> entries;
 
-#if defined(APRSERVICE_WIN32)
-	WSACleanup();
-#endif
+	entries.reserve(filter->size);
 
-	delete connection;
-}
-bool                                       aprservice_connection_is_open(aprservice_connection* connection)
-{
-	return connection->is_open;
-}
-bool                                       aprservice_connection_open_tcp(aprservice_connection* connection)
-{
-resolve_host:
-	addrinfo  dns_hint = { .ai_family = AF_UNSPEC };
-	addrinfo* dns_result;
+	for (auto& entry : filter->entries)
+		if (entry.hash && ((time - entry.time) < filter->window))
+			entries.push_back(entry);
 
-	if (auto error = getaddrinfo(connection->host_or_device.c_str(), "", &dns_hint, &dns_result))
+	if (entries.size() > filter->max_size)
 	{
-		switch (error)
-		{
-			case EAI_FAIL:
-			case EAI_AGAIN:
-			case EAI_NONAME:
-				break;
-
-			default:
-				aprservice_log_error(getaddrinfo, error);
-				break;
-		}
+		std::nth_element(entries.begin(), entries.begin() + filter->max_size, entries.end(), [time](auto& a, auto& b) { return (time - a.time) < (time - b.time); });
 
-		return false;
+		entries.resize(filter->max_size);
 	}
 
-	union
-	{
-		sockaddr_in  dns_result_ipv4;
-		sockaddr_in6 dns_result_ipv6;
-	};
-
-	sockaddr* dns_result_address;
-	int       dns_result_address_length = 0;
+	size_t capacity = 256;
 
-	switch (dns_result->ai_family)
-	{
-		case AF_INET:
-			dns_result_ipv4          = *reinterpret_cast<const sockaddr_in*>(dns_result->ai_addr);
-			dns_result_ipv4.sin_port = htons(connection->port);
-			dns_result_address        = reinterpret_cast<sockaddr*>(&dns_result_ipv4);
-			dns_result_address_length = sizeof(sockaddr_in);
-			break;
+	while (capacity < (entries.size() * 4))
+		capacity *= 2;
 
-		case AF_INET6:
-			dns_result_ipv6           = *reinterpret_cast<const sockaddr_in6*>(dns_result->ai_addr);
-			dns_result_ipv6.sin6_port = htons(connection->port);
-			dns_result_address        = reinterpret_cast<sockaddr*>(&dns_result_ipv6);
-			dns_result_address_length = sizeof(sockaddr_in6);
-			break;
-	}
+	filter->size = entries.size();
+	filter->entries.assign(capacity, { .hash = 0, .time = 0 });
 
-	freeaddrinfo(dns_result);
+	for (auto& entry : entries)
+		for (size_t i = entry.hash & (capacity - 1); ; i = (i + 1) & (capacity - 1))
+			if (!filter->entries[i].hash)
+			{
+				filter->entries[i] = entry;
 
-	if (!dns_result_address_length)
+				break;
+			}
+}
+// @return true if the hash was already seen within the window
+bool                                       aprservice_duplicate_filter_check(aprservice_duplicate_filter* filter, uint64_t hash, uint32_t time)
+{
+	if (!filter->is_enabled || !filter->window)
 		return false;
 
-socket_open:
-#if defined(APRSERVICE_UNIX)
-	if ((connection->socket = socket(dns_result_address->sa_family, SOCK_STREAM, IPPROTO_TCP)) == -1)
-	{
-		auto error = errno;
-
-		aprservice_log_error(socket, error);
-
+	if (!hash)
 		return false;
-	}
-#elif defined(APRSERVICE_WIN32)
-	if ((connection->socket = WSASocketW(dns_result_address->sa_family, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, 0)) == INVALID_SOCKET)
-	{
-		auto error = WSAGetLastError();
 
-		aprservice_log_error(WSASocketW, error);
+	if (filter->entries.empty())
+		aprservice_duplicate_filter_rehash(filter, time);
 
-		return false;
-	}
-#endif
+	auto                               mask = filter->entries.size() - 1;
+	aprservice_duplicate_filter_entry* slot = nullptr;
 
-socket_connect:
-#if defined(APRSERVICE_UNIX)
-	if (connect(connection->socket, dns_result_address, dns_result_address_length) == -1)
+	for (size_t i = hash & mask; ; i = (i + 1) & mask)
 	{
-		auto error = errno;
+		auto entry = &filter->entries[i];
 
-		aprservice_log_error(connect, error);
+		if (!entry->hash)
+		{
+			if (!slot)
+			{
+				slot = entry;
 
-		close(connection->socket);
+				++filter->size;
+			}
 
-		return false;
-	}
+			break;
+		}
 
-	int flags;
+		if (bool is_expired = (time - entry->time) >= filter->window; !is_expired && (entry->hash == hash))
+		{
+			++filter->drop_count;
 
-	if ((flags = fcntl(connection->socket, F_GETFL, 0)) == -1)
-	{
-		auto error = errno;
+			return true;
+		}
+		else if (is_expired && !slot)
+			slot = entry;
+	}
 
-		aprservice_log_error(fcntl, error);
+	*slot = { .hash = hash, .time = time };
 
-		close(connection->socket);
+	if ((filter->size * 4) >= (filter->entries.size() * 3))
+		aprservice_duplicate_filter_rehash(filter, time);
 
+	return false;
+}
+// messages to this station are left to the message filter, a retransmission means the ack was lost and has to be sent again
+bool                                       aprservice_duplicate_filter_is_exempt(struct aprservice* service, std::string_view content)
+{
+	if ((content.length() < 11) || (content[0] != ':') || (content[10] != ':'))
 		return false;
-	}
 
-	flags |= O_NONBLOCK;
+	auto destination = content.substr(1, 9);
 
-	if (fcntl(connection->socket, F_SETFL, flags) == -1)
-	{
-		auto error = errno;
+	while (!destination.empty() && (destination.back() == ' '))
+		destination.remove_suffix(1);
 
-		aprservice_log_error(fcntl, error);
+	return (destination.length() == service->station.length()) && std::equal(destination.begin(), destination.end(), service->station.begin(), [](char a, char b) { return tolower((uint8_t)a) == tolower((uint8_t)b); });
+}
+// @return true if the packet was already seen within the window
+bool                                       aprservice_duplicate_filter_check(struct aprservice* service, std::string_view sender, std::string_view tocall, std::string_view content)
+{
+	if (!service->duplicate_filter.is_enabled || aprservice_duplicate_filter_is_exempt(service, content))
+		return false;
 
-		close(connection->socket);
+	return aprservice_duplicate_filter_check(&service->duplicate_filter, aprservice_duplicate_filter_hash(sender, tocall, content), aprservice_get_time(service));
+}
+// @return false if the line has no sender, tocall or content
+bool                                       aprservice_duplicate_filter_check(struct aprservice* service, std::string_view line)
+{
+	auto i = line.find('>');
+	auto j = (i == line.npos) ? line.npos : line.find_first_of(",:", i + 1);
+	auto k = (j == line.npos) ? line.npos : line.find(':', j);
 
+	if ((i == 0) || (k == line.npos))
 		return false;
-	}
-#elif defined(APRSERVICE_WIN32)
-	if (connect(connection->socket, dns_result_address, dns_result_address_length) == SOCKET_ERROR)
-	{
-		auto error = WSAGetLastError();
 
-		aprservice_log_error(connect, error);
+	return aprservice_duplicate_filter_check(service, line.substr(0, i), line.substr(i + 1, j - (i + 1)), line.substr(k + 1));
+}
 
-		closesocket(connection->socket);
+std::string                                aprservice_message_callback_queue_key(std::string_view station, std::string_view id)
+{
+	std::string key;
 
-		return false;
-	}
+	key.reserve(station.length() + 1 + id.length());
+	key.append(station);
+	key.push_back(':');
+	key.append(id);
 
-	u_long arg = 1;
+	return key;
+}
+void                                       aprservice_message_callback_queue_swap(aprservice_message_callback_queue* queue, size_t a, size_t b)
+{
+	std::swap(queue->heap[a], queue->heap[b]);
 
-	if (ioctlsocket(connection->socket, FIONBIO, &arg))
+	queue->heap[a]->heap_index = a;
+	queue->heap[b]->heap_index = b;
+}
+void                                       aprservice_message_callback_queue_sift_up(aprservice_message_callback_queue* queue, size_t i)
+{
+	for (size_t parent; i && (queue->heap[i]->timeout < queue->heap[parent = (i - 1) / 2]->timeout); i = parent)
+		aprservice_message_callback_queue_swap(queue, i, parent);
+}
+void                                       aprservice_message_callback_queue_sift_down(aprservice_message_callback_queue* queue, size_t i)
+{
+	for (size_t size = queue->heap.size();;)
 	{
-		auto error = WSAGetLastError();
+		auto min   = i;
+		auto left  = (i * 2) + 1;
+		auto right = (i * 2) + 2;
 
-		aprservice_log_error(ioctlsocket, error);
+		if ((left < size) && (queue->heap[left]->timeout < queue->heap[min]->timeout))
+			min = left;
 
-		closesocket(connection->socket);
+		if ((right < size) && (queue->heap[right]->timeout < queue->heap[min]->timeout))
+			min = right;
 
-		return false;
-	}
-#endif
+		if (min == i)
+			break;
 
-	connection->is_open = true;
+		aprservice_message_callback_queue_swap(queue, i, min);
 
-	return true;
+		i = min;
+	}
 }
-bool                                       aprservice_connection_open_serial(aprservice_connection* connection)
+void                                       aprservice_message_callback_queue_push(aprservice_message_callback_queue* queue, aprservice_message_callback_context* context)
 {
-#if defined(APRSERVICE_UNIX)
-	if ((connection->serial = open(connection->host_or_device.c_str(), O_RDWR | O_NOCTTY)) == -1)
-	{
-		auto error = errno;
+	context->heap_index = queue->heap.size();
 
-		aprservice_log_error(open, error);
+	queue->heap.push_back(context);
+	queue->index.emplace(context->key, context);
 
-		return false;
+	aprservice_message_callback_queue_sift_up(queue, context->heap_index);
+}
+void                                       aprservice_message_callback_queue_remove(aprservice_message_callback_queue* queue, aprservice_message_callback_context* context)
+{
+	auto i    = context->heap_index;
+	auto last = queue->heap.size() - 1;
+
+	if (i != last)
+	{
+		aprservice_message_callback_queue_swap(queue, i, last);
+		queue->heap.pop_back();
+
+		aprservice_message_callback_queue_sift_up(queue, i);
+		aprservice_message_callback_queue_sift_down(queue, i);
 	}
+	else
+		queue->heap.pop_back();
 
-	fcntl(connection->serial, F_SETFL, O_RDWR);
+	for (auto [it, end] = queue->index.equal_range(context->key); it != end; ++it)
+		if (it->second == context)
+		{
+			queue->index.erase(it);
 
-	termios options;
-	tcgetattr(connection->serial, &options);
-	cfmakeraw(&options);
-	cfsetspeed(&options, connection->device_speed);
+			break;
+		}
+}
+// @return nullptr if not found
+aprservice_message_callback_context*       aprservice_message_callback_queue_find(aprservice_message_callback_queue* queue, std::string_view station, std::string_view id)
+{
+	if (auto it = queue->index.find(aprservice_message_callback_queue_key(station, id)); it != queue->index.end())
+		return it->second;
 
-	options.c_cc[VMIN]  = 1;
-	options.c_cc[VTIME] = 0;
-	options.c_cflag    |= CS8;
-	options.c_cflag    |= CLOCAL | CREAD;
-	options.c_cflag    &= ~(PARENB | CSTOPB | CSIZE);
-	options.c_cflag    &= ~(ICANON | ECHO | ECHOE | ISIG | OPOST);
+	return nullptr;
+}
+// @return nullptr if nothing has expired at time
+aprservice_message_callback_context*       aprservice_message_callback_queue_pop(aprservice_message_callback_queue* queue, uint64_t time)
+{
+	if (queue->heap.empty() || (time < queue->heap.front()->timeout))
+		return nullptr;
 
-	tcsetattr(connection->serial, TCSANOW, &options);
+	auto context = queue->heap.front();
 
-	int status;
+	aprservice_message_callback_queue_remove(queue, context);
 
-	if (ioctl(connection->serial, TIOCMGET, &status) == -1)
-	{
-		auto error = errno;
+	return context;
+}
 
-		aprservice_log_error(ioctl, error);
+void                                       aprservice_task_link_init(aprservice_task_link* link)
+{
+	link->prev = link;
+	link->next = link;
+}
+// inserts link at the end of list
+void                                       aprservice_task_link_insert(aprservice_task_link* list, aprservice_task_link* link)
+{
+	link->prev       = list->prev;
+	link->next       = list;
+	list->prev->next = link;
+	list->prev       = link;
+}
+void                                       aprservice_task_link_remove(aprservice_task_link* link)
+{
+	link->prev->next = link->next;
+	link->next->prev = link->prev;
 
-		close(connection->serial);
+	aprservice_task_link_init(link);
+}
+// moves every link in list to the end of destination
+void                                       aprservice_task_link_splice(aprservice_task_link* destination, aprservice_task_link* list)
+{
+	if (list->next != list)
+	{
+		list->next->prev        = destination->prev;
+		destination->prev->next = list->next;
+		list->prev->next        = destination;
+		destination->prev       = list->prev;
 
-		return false;
+		aprservice_task_link_init(list);
 	}
+}
 
-	status |= TIOCM_DTR | TIOCM_RTS;
+void                                       aprservice_task_wheel_init(aprservice_task_wheel* wheel)
+{
+	wheel->time = 0;
+	wheel->size = 0;
 
-	if (ioctl(connection->serial, TIOCMSET, &status) == -1)
-	{
-		auto error = errno;
+	for (auto& level : wheel->slots)
+		for (auto& slot : level)
+			aprservice_task_link_init(&slot);
+}
+void                                       aprservice_task_wheel_insert(aprservice_task_wheel* wheel, aprservice_task* task)
+{
+	auto   time  = std::max(task->time, wheel->time);
+	size_t level = 0;
 
-		aprservice_log_error(ioctl, error);
+	while ((level < (APRSERVICE_TASK_WHEEL_LEVELS - 1)) && ((time - wheel->time) >> ((level + 1) * APRSERVICE_TASK_WHEEL_SLOT_BITS)))
+		++level;
 
-		close(connection->serial);
+	// beyond the last level, cascading will move it closer
+	if ((time - wheel->time) >> (APRSERVICE_TASK_WHEEL_LEVELS * APRSERVICE_TASK_WHEEL_SLOT_BITS))
+		time = wheel->time + (1ull << (APRSERVICE_TASK_WHEEL_LEVELS * APRSERVICE_TASK_WHEEL_SLOT_BITS)) - 1;
 
-		return false;
-	}
+	aprservice_task_link_insert(&wheel->slots[level][(time >> (level * APRSERVICE_TASK_WHEEL_SLOT_BITS)) & (APRSERVICE_TASK_WHEEL_SLOTS - 1)], &task->link);
+}
+// moves every task in a slot of level to the level below
+void                                       aprservice_task_wheel_cascade(aprservice_task_wheel* wheel, size_t level, size_t index)
+{
+	aprservice_task_link list;
 
-	int flags;
+	aprservice_task_link_init(&list);
+	aprservice_task_link_splice(&list, &wheel->slots[level][index]);
 
-	if ((flags = fcntl(connection->serial, F_GETFL, 0)) == -1)
+	while (list.next != &list)
 	{
-		auto error = errno;
+		auto task = reinterpret_cast<aprservice_task*>(list.next);
 
-		aprservice_log_error(fcntl, error);
-
-		close(connection->serial);
-
-		return false;
+		aprservice_task_link_remove(&task->link);
+		aprservice_task_wheel_insert(wheel, task);
 	}
+}
+// moves every task due at wheel->time into expired and advances wheel->time
+void                                       aprservice_task_wheel_advance(aprservice_task_wheel* wheel, aprservice_task_link* expired)
+{
+	auto index = wheel->time & (APRSERVICE_TASK_WHEEL_SLOTS - 1);
 
-	flags |= O_NONBLOCK;
+	if (!index)
+		for (size_t level = 1; level < APRSERVICE_TASK_WHEEL_LEVELS; ++level)
+		{
+			auto level_index = (wheel->time >> (level * APRSERVICE_TASK_WHEEL_SLOT_BITS)) & (APRSERVICE_TASK_WHEEL_SLOTS - 1);
 
-	if (fcntl(connection->serial, F_SETFL, flags) == -1)
-	{
-		auto error = errno;
+			aprservice_task_wheel_cascade(wheel, level, level_index);
 
-		aprservice_log_error(fcntl, error);
+			if (level_index)
+				break;
+		}
 
-		close(connection->serial);
+	aprservice_task_link_splice(expired, &wheel->slots[0][index]);
 
-		return false;
-	}
-#elif defined(APRSERVICE_WIN32)
-	if ((connection->serial = CreateFileA(connection->host_or_device.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0)) == INVALID_HANDLE_VALUE)
-	{
-		auto error = GetLastError();
+	++wheel->time;
+}
+// @return earliest time a task may be due, UINT64_MAX if there are none
+uint64_t                                   aprservice_task_wheel_get_next_time(aprservice_task_wheel* wheel)
+{
+	if (!wheel->size)
+		return UINT64_MAX;
 
-		aprservice_log_error(CreateFileA, error);
+	// tasks on higher levels are not due before the next cascade
+	auto cascade_time = (wheel->time | (APRSERVICE_TASK_WHEEL_SLOTS - 1)) + 1;
 
-		return false;
-	}
+	for (auto time = wheel->time; time < cascade_time; ++time)
+		if (auto slot = &wheel->slots[0][time & (APRSERVICE_TASK_WHEEL_SLOTS - 1)]; slot->next != slot)
+			return time;
 
-	DCB dcb       = {};
-	dcb.DCBlength = sizeof(DCB);
+	return cascade_time;
+}
 
-	if (!GetCommState(connection->serial, &dcb))
+// @return pointer to at least size writable bytes
+char*                                      aprservice_connection_rx_buffer_reserve(aprservice_connection_rx_buffer* buffer, size_t size)
+{
+	if ((buffer->data.size() - buffer->write) < size)
 	{
-		auto error = GetLastError();
-
-		aprservice_log_error(GetCommState, error);
+		if (buffer->read)
+		{
+			memmove(buffer->data.data(), buffer->data.data() + buffer->read, buffer->write - buffer->read);
 
-		CloseHandle(connection->serial);
+			buffer->scan  -= buffer->read;
+			buffer->write -= buffer->read;
+			buffer->read   = 0;
+		}
 
-		return false;
+		if ((buffer->data.size() - buffer->write) < size)
+			buffer->data.resize(std::max(buffer->data.size() * 2, buffer->write + size));
 	}
 
-	dcb.Parity   = NOPARITY;
-	dcb.fBinary  = TRUE;
-	dcb.BaudRate = connection->device_speed;
-	dcb.ByteSize = 8;
-	dcb.StopBits = ONESTOPBIT;
+	return buffer->data.data() + buffer->write;
+}
+void                                       aprservice_connection_rx_buffer_commit(aprservice_connection_rx_buffer* buffer, size_t size)
+{
+	buffer->write += size;
+}
+void                                       aprservice_connection_rx_buffer_write(aprservice_connection_rx_buffer* buffer, const void* data, size_t size)
+{
+	memcpy(aprservice_connection_rx_buffer_reserve(buffer, size), data, size);
 
-	if (!SetCommState(connection->serial, &dcb))
+	aprservice_connection_rx_buffer_commit(buffer, size);
+}
+void                                       aprservice_connection_rx_buffer_consume(aprservice_connection_rx_buffer* buffer, size_t size)
+{
+	if ((buffer->read += size) == buffer->write)
+		buffer->read = buffer->scan = buffer->write = 0;
+	else if (buffer->scan < buffer->read)
+		buffer->scan = buffer->read;
+}
+void                                       aprservice_connection_rx_buffer_clear(aprservice_connection_rx_buffer* buffer)
+{
+	buffer->read  = 0;
+	buffer->scan  = 0;
+	buffer->write = 0;
+}
+std::string_view                           aprservice_connection_rx_buffer_get(aprservice_connection_rx_buffer* buffer)
+{
+	return std::string_view(buffer->data.data() + buffer->read, buffer->write - buffer->read);
+}
+// @return false if no complete line is buffered
+// value is valid until the buffer is next written to
+bool                                       aprservice_connection_rx_buffer_read_line(aprservice_connection_rx_buffer* buffer, std::string_view& value)
+{
+	auto data = buffer->data.data();
+
+	while (auto end = (const char*)memchr(data + buffer->scan, '\n', buffer->write - buffer->scan))
 	{
-		auto error = GetLastError();
+		auto i = (size_t)(end - data);
 
-		aprservice_log_error(SetCommState, error);
+		buffer->scan = i + 1;
 
-		CloseHandle(connection->serial);
+		if ((i > buffer->read) && (data[i - 1] == '\r'))
+		{
+			value = std::string_view(data + buffer->read, (i - 1) - buffer->read);
 
-		return false;
+			aprservice_connection_rx_buffer_consume(buffer, buffer->scan - buffer->read);
+
+			return true;
+		}
 	}
 
-	COMMTIMEOUTS timeouts = {};
+	buffer->scan = buffer->write;
 
-	if (!SetCommTimeouts(connection->serial, &timeouts))
-	{
-		auto error = GetLastError();
+	return false;
+}
 
-		aprservice_log_error(SetCommTimeouts, error);
+void                                       aprservice_connection_rx_queue_clear(aprservice_connection_rx_queue* queue)
+{
+	queue->size  = 0;
+	queue->front = 0;
+	queue->entries.clear();
+}
+void                                       aprservice_connection_rx_queue_push(aprservice_connection_rx_queue* queue, std::string_view value)
+{
+	if ((queue->data.size() - queue->size) <= value.length())
+		queue->data.resize(std::max(queue->data.size() * 2, queue->size + value.length() + 1));
 
-		CloseHandle(connection->serial);
+	memcpy(queue->data.data() + queue->size, value.data(), value.length());
+	queue->data[queue->size + value.length()] = '\0';
+
+	queue->entries.push_back({ .offset = queue->size, .length = value.length() });
+
+	queue->size += value.length() + 1;
+}
+// @return false if the queue is empty
+// value is null terminated and valid until the queue is next pushed to
+bool                                       aprservice_connection_rx_queue_pop(aprservice_connection_rx_queue* queue, std::string_view& value)
+{
+	if (queue->front == queue->entries.size())
+	{
+		aprservice_connection_rx_queue_clear(queue);
 
 		return false;
 	}
-#endif
 
-	connection->is_open = true;
+	auto& entry = queue->entries[queue->front++];
+
+	value = std::string_view(queue->data.data() + entry.offset, entry.length);
 
 	return true;
 }
-bool                                       aprservice_connection_open(aprservice_connection* connection)
-{
-	if (aprservice_connection_is_open(connection))
-		return false;
 
-	switch (connection->type)
+void                                       aprservice_connection_kiss_deframer_reset(aprservice_connection_kiss_deframer* deframer)
+{
+	deframer->state = KISS_TNC_DEFRAMER_STATE_SYNC;
+	deframer->frame.clear();
+}
+// @return true if byte completed a frame
+// frame is valid until the deframer is next pushed to
+bool                                       aprservice_connection_kiss_deframer_push(aprservice_connection_kiss_deframer* deframer, uint8_t byte)
+{
+	switch (deframer->state)
 	{
-		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
-			if (!aprservice_connection_open_tcp(connection))
-			{
-				// aprservice_log_error(aprservice_connection_open_tcp, false);
+		case KISS_TNC_DEFRAMER_STATE_SYNC:
+			if (byte == KISS_TNC_SPECIAL_CHARACTER_FRAME_END)
+				deframer->state = KISS_TNC_DEFRAMER_STATE_COMMAND;
+			break;
 
-				return false;
+		case KISS_TNC_DEFRAMER_STATE_COMMAND:
+			if (byte != KISS_TNC_SPECIAL_CHARACTER_FRAME_END)
+			{
+				deframer->state   = KISS_TNC_DEFRAMER_STATE_DATA;
+				deframer->command = byte;
+				deframer->frame.clear();
 			}
 			break;
 
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
-			if (!aprservice_connection_open_serial(connection))
+		case KISS_TNC_DEFRAMER_STATE_DATA:
+			switch (byte)
 			{
-				// aprservice_log_error(aprservice_connection_open_serial, false);
+				case KISS_TNC_SPECIAL_CHARACTER_FRAME_END:
+					deframer->state = KISS_TNC_DEFRAMER_STATE_COMMAND;
+					return true;
 
-				return false;
+				case KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE:
+					deframer->state = KISS_TNC_DEFRAMER_STATE_ESCAPE;
+					break;
+
+				default:
+					if (deframer->frame.size() == APRSERVICE_CONNECTION_KISS_FRAME_SIZE)
+					{
+						// noise or a peer that never ends the frame, wait for the next frame end
+						aprservice_connection_kiss_deframer_reset(deframer);
+
+						break;
+					}
+
+					deframer->frame.push_back(byte);
+					break;
 			}
 			break;
-	}
-
-	aprservice_event_execute(connection->service, APRSERVICE_EVENT_CONNECT, { });
 
-	static auto generate_auth_request = [](aprservice* service, uint16_t passcode)
-	{
-		std::stringstream ss;
-		ss << "user " << service->station << " pass " << (passcode ? passcode : -1);
-		ss << " vers " << APRSERVICE_SOFTWARE_NAME << ' ' << APRSERVICE_SOFTWARE_VERSION;
-		ss << " filter t/poimqstunw";
+		case KISS_TNC_DEFRAMER_STATE_ESCAPE:
+			if (deframer->frame.size() == APRSERVICE_CONNECTION_KISS_FRAME_SIZE)
+			{
+				aprservice_connection_kiss_deframer_reset(deframer);
 
-		return ss.str();
-	};
+				break;
+			}
 
-	switch (connection->type)
-	{
-		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
-			if (auto auth_request = generate_auth_request(connection->service, connection->passcode); !aprservice_connection_write_aprs_is(connection, std::move(auth_request)))
+			switch (byte)
 			{
-				aprservice_log_error(aprservice_connection_write_aprs_is, false);
+				// frame aborted
+				case KISS_TNC_SPECIAL_CHARACTER_FRAME_END:
+					deframer->state = KISS_TNC_DEFRAMER_STATE_COMMAND;
+					return false;
 
-				aprservice_connection_close(connection);
+				case KISS_TNC_SPECIAL_CHARACTER_TRANSPOSED_FRAME_END:
+					deframer->frame.push_back(KISS_TNC_SPECIAL_CHARACTER_FRAME_END);
+					break;
 
-				return false;
+				case KISS_TNC_SPECIAL_CHARACTER_TRANSPOSED_FRAME_ESCAPE:
+					deframer->frame.push_back(KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE);
+					break;
 			}
-			connection->auth.state    = APRSERVICE_AUTH_STATE_SENT;
-			connection->auth.success  = false;
-			connection->auth.verified = false;
-			break;
 
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
-			connection->auth.state    = APRSERVICE_AUTH_STATE_RECEIVED;
-			connection->auth.success  = true;
-			connection->auth.verified = true;
-			connection->auth.message.clear();
-			aprservice_event_execute(connection->service, APRSERVICE_EVENT_AUTHENTICATE, { .message = connection->auth.message.c_str(), .success = connection->auth.success, .verified = connection->auth.verified });
+			deframer->state = KISS_TNC_DEFRAMER_STATE_DATA;
 			break;
 	}
 
-	return true;
+	return false;
 }
-void                                       aprservice_connection_close(aprservice_connection* connection)
+
+// @return pointer to the byte after the address
+uint8_t*                                   aprservice_ax25_encode_address(uint8_t* buffer, const char* station, bool repeated, bool is_last)
 {
-	if (aprservice_connection_is_open(connection))
-	{
-		switch (connection->type)
-		{
-			case APRSERVICE_CONNECTION_TYPE_APRS_IS:
-			case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
-#if defined(APRSERVICE_UNIX)
-				close(connection->socket);
-#elif defined(APRSERVICE_WIN32)
-				closesocket(connection->socket);
-#endif
-				break;
+	size_t i = 0;
 
-			case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
-#if defined(APRSERVICE_UNIX)
-				close(connection->serial);
-#elif defined(APRSERVICE_WIN32)
-				CloseHandle(connection->serial);
-#endif
-				break;
-		}
+	for (; (i < 6) && *station && (*station != '-'); ++i)
+		*(buffer++) = *(station++) << 1;
 
-		connection->rx_buffer.clear();
+	for (; i < 6; ++i)
+		*(buffer++) = ' ' << 1;
 
-		while (!connection->rx_queue.empty())
-			connection->rx_queue.pop();
+	uint8_t ssid = (*station == '-') ? aprservice_parse_uint<uint8_t>(station + 1) : 0;
 
-		while (!connection->tx_queue.empty())
-			connection->tx_queue.pop();
+	*(buffer++) = 0x60 | ((ssid & 0x0F) << 1) | (repeated ? 0x80 : 0x00) | (is_last ? 0x01 : 0x00);
 
-		connection->is_open = false;
+	return buffer;
+}
+// defined in APRS.cpp
+// @return offset of the information field, 0 if buffer is not a ui frame
+size_t                                     aprs_extract_ax25_header(const uint8_t* buffer, size_t size, std::string& tocall, std::string& sender, aprs_path* path);
+// hashes the sender, tocall and information field straight from the frame so duplicates are never decoded
+// @return true if the frame was already seen within the window
+bool                                       aprservice_duplicate_filter_check(struct aprservice* service, const uint8_t* frame, size_t size)
+{
+	if (!service->duplicate_filter.is_enabled)
+		return false;
 
-		connection->auth.state = APRSERVICE_AUTH_STATE_NONE;
+	std::string tocall;
+	std::string sender;
 
-		aprservice_event_execute(connection->service, APRSERVICE_EVENT_DISCONNECT, { });
-	}
+	if (auto offset = aprs_extract_ax25_header(frame, size, tocall, sender, nullptr))
+		return aprservice_duplicate_filter_check(service, sender, tocall, std::string_view((const char*)&frame[offset], size - offset));
+
+	return false;
 }
-// @return false on connection closed
-bool                                       aprservice_connection_poll_aprs_is(aprservice_connection* connection)
+// encodes the address, control and protocol fields of a ui frame
+void                                       aprservice_ax25_encode_header(std::vector<uint8_t>& buffer, const char* sender, const char* tocall, aprs_path* path)
 {
-	size_t number_of_bytes_received;
+	auto path_node   = aprs_path_get(path);
+	auto path_length = aprs_path_get_length(path);
 
-read_once:
-	switch (aprservice_connection_read(connection, &connection->rx_buffer_tmp[0], connection->rx_buffer_tmp.max_size(), &number_of_bytes_received))
-	{
-		case 0:
-			return false;
+	buffer.resize(14 + (path_length * 7) + 2);
 
-		case -1:
-			break;
+	auto b = aprservice_ax25_encode_address(buffer.data(), tocall, false, false);
+	b      = aprservice_ax25_encode_address(b, sender, false, !path_length);
 
-		default:
-			connection->rx_buffer.append(&connection->rx_buffer_tmp[0], number_of_bytes_received);
+	for (size_t i = 1; i <= path_length; ++i, ++path_node)
+		b = aprservice_ax25_encode_address(b, path_node->station, path_node->repeated, i == path_length);
 
-			for (auto i = connection->rx_buffer.find("\r\n"); i != std::string::npos; i = connection->rx_buffer.find("\r\n"))
-			{
-				connection->rx_queue.push(connection->rx_buffer.substr(0, i));
-				connection->rx_buffer = connection->rx_buffer.erase(0, i + 2);
-			}
-			goto read_once;
-	}
+	*(b++) = 0x03;
+	*(b++) = 0xF0;
+}
+// rebuilds the cached header for the station, tocall and path of the service
+void                                       aprservice_ax25_header_update(aprservice* service)
+{
+	aprservice_ax25_encode_header(service->ax25_header, service->station.c_str(), APRSERVICE_TOCALL, service->path);
 
-	return true;
+	service->ax25_header_path_hash = aprs_path_hash(service->path);
 }
-// @return false on connection closed
-bool                                       aprservice_connection_poll_kiss_tnc(aprservice_connection* connection)
+void                                       aprservice_ax25_encode_packet(aprservice* service, std::vector<uint8_t>& buffer, aprs_packet* packet, const char* content)
 {
-	size_t number_of_bytes_received;
+	auto path = aprs_packet_get_path(packet);
 
-read_once:
-	switch (aprservice_connection_read(connection, &connection->rx_buffer_tmp[0], connection->rx_buffer_tmp.max_size(), &number_of_bytes_received))
+	if (!strcmp(aprs_packet_get_sender(packet), service->station.c_str()) && !strcmp(aprs_packet_get_tocall(packet), APRSERVICE_TOCALL) && ((path == service->path) || aprs_path_compare(path, service->path)))
 	{
-		case 0:
-			return false;
+		// the path may have been modified in place
+		if (aprs_path_hash(service->path) != service->ax25_header_path_hash)
+			aprservice_ax25_header_update(service);
 
-		case -1:
-			break;
+		buffer.assign(service->ax25_header.begin(), service->ax25_header.end());
+	}
+	else
+		aprservice_ax25_encode_header(buffer, aprs_packet_get_sender(packet), aprs_packet_get_tocall(packet), path);
 
-		default:
-			connection->rx_buffer.append(&connection->rx_buffer_tmp[0], number_of_bytes_received);
+	buffer.insert(buffer.end(), content, content + strlen(content));
+}
+void                                       aprservice_kiss_encode_frame(std::string& buffer, const uint8_t* value, size_t size)
+{
+	buffer.clear();
+	buffer.reserve(1 + 1 + size + 1);
+	buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_FRAME_END);
+	buffer.append(1, (char)KISS_TNC_COMMAND_DATA);
 
-		parse_once:
-			uint8_t              command;
-			std::vector<uint8_t> command_buffer;
+	for (auto end = value + size; value != end; ++value)
+		switch (*value)
+		{
+			case KISS_TNC_SPECIAL_CHARACTER_FRAME_END:
+				buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE);
+				buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_TRANSPOSED_FRAME_END);
+				break;
 
-			command_buffer.reserve(connection->rx_buffer.length());
+			case KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE:
+				buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE);
+				buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_TRANSPOSED_FRAME_ESCAPE);
+				break;
 
-			for (size_t i = 0, e = 0; i < connection->rx_buffer.length(); ++i)
-				if (connection->rx_buffer[i] == (char)KISS_TNC_SPECIAL_CHARACTER_FRAME_END)
-					for (size_t j = i + 2; j < connection->rx_buffer.length(); ++j)
-						switch (uint8_t byte = connection->rx_buffer[j])
-						{
-							case KISS_TNC_SPECIAL_CHARACTER_FRAME_END:
-								if (e)
-									command_buffer.push_back(KISS_TNC_SPECIAL_CHARACTER_FRAME_END);
-								else
-								{
-									command               = connection->rx_buffer[i + 1] & 0x0F;
-									connection->rx_buffer = connection->rx_buffer.erase(0, j + 1);
-
-									if ((command & 0x0F) == KISS_TNC_COMMAND_DATA)
-									{
-										std::string string;
-
-										string.reserve(command_buffer.size());
-
-										static auto command_decode_path    = [](std::string& string, const std::vector<uint8_t>& buffer, size_t offset)
-										{
-											bool is_last;
-
-											do
-											{
-												string.append(1, ',');
-
-												is_last = buffer[offset + 6] & 0x01;
-
-												for (size_t i = 0; i < 6; ++i, ++offset)
-													if (buffer[offset] != 0x40)
-														string.append(1, (char)(buffer[offset] >> 1));
-
-												bool is_repeated = buffer[offset] & 0x80;
-
-												if (uint8_t ssid = ((buffer[offset++] & 0x0E) >> 1))
-												{
-													string.append(1, '-');
-
-													do
-														string.append(1, '0' + ssid % 10);
-													while (ssid /= 10);
-												}
-
-												if (is_repeated)
-													string.append(1, '*');
-											} while (!is_last);
-
-											return offset;
-										};
-										static auto command_decode_tocall  = [](std::string& string, const std::vector<uint8_t>& buffer, size_t offset)
-										{
-											for (size_t i = 0; i < 6; ++i, ++offset)
-												if (buffer[offset] != 0x40)
-													string.append(1, (char)(buffer[offset] >> 1));
-
-											if (uint8_t ssid = ((buffer[offset++] & 0x1E) >> 1))
-											{
-												string.append(1, '-');
-
-												do
-													string.append(1, '0' + ssid % 10);
-												while (ssid /= 10);
-											}
-										};
-										static auto command_decode_station = [](std::string& string, const std::vector<uint8_t>& buffer, size_t offset)
-										{
-											for (size_t i = 0; i < 6; ++i, ++offset)
-												if (buffer[offset] != 0x40)
-													string.append(1, (char)(buffer[offset] >> 1));
-
-											if (uint8_t ssid = ((buffer[offset++] & 0x1E) >> 1))
-											{
-												string.append(1, '-');
-
-												do
-													string.append(1, '0' + ssid % 10);
-												while (ssid /= 10);
-											}
-
-											string.append(1, '>');
-										};
-
-										command_decode_station(string, command_buffer, 7);
-										command_decode_tocall(string, command_buffer, 0);
-										auto offset = command_decode_path(string, command_buffer, 14);
-
-										if ((command_buffer[offset++] == 0x03) && (command_buffer[offset++] == 0xF0))
-										{
-											string.append(1, ':');
-
-											if (command_buffer.back() != '\r')
-												string.append((const char*)&command_buffer[offset], command_buffer.size() - offset);
-											else
-												string.append((const char*)&command_buffer[offset], (command_buffer.size() - offset) - 1);
-
-											connection->rx_queue.push(std::move(string));
-										}
-									}
-
-									goto parse_once;
-								}
-								break;
+			default:
+				buffer.append(1, (char)*value);
+				break;
+		}
 
-							case KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE:
-								e = e ? 0 : 1;
-								break;
+	buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_FRAME_END);
+}
+// @return milliseconds needed to transmit the ax.25 frame inside value at baud_rate
+uint32_t                                   aprservice_kiss_frame_get_airtime(const std::string& value, uint32_t baud_rate)
+{
+	if (!baud_rate || (value.length() < 3))
+		return 0;
 
-							case KISS_TNC_SPECIAL_CHARACTER_TRANSPOSED_FRAME_END:
-								if (e) command_buffer.push_back(KISS_TNC_SPECIAL_CHARACTER_FRAME_END);
-								break;
+	// frame end and command, then frame end
+	size_t size = value.length() - 3;
 
-							case KISS_TNC_SPECIAL_CHARACTER_TRANSPOSED_FRAME_ESCAPE:
-								if (e) command_buffer.push_back(KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE);
-								break;
+	for (size_t i = 2; i < (value.length() - 1); ++i)
+		if ((uint8_t)value[i] == KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE)
+			--size;
 
-							default:
-								command_buffer.push_back((char)byte);
-								break;
-						}
-			goto read_once;
-	}
+	// flags and fcs
+	size += 4;
 
-	return true;
+	return (uint32_t)(((size * 8 * 1000) + (baud_rate - 1)) / baud_rate);
 }
-bool                                       aprservice_connection_poll(aprservice_connection* connection)
-{
-	if (!aprservice_connection_is_open(connection))
-		return false;
 
-	size_t number_of_bytes_transferred;
+aprservice_connection*                     aprservice_connection_init(aprservice* service, int type, const char* host_or_device, uint16_t port, uint32_t speed, uint16_t passcode);
+void                                       aprservice_connection_deinit(aprservice_connection* connection);
+bool                                       aprservice_connection_is_open(aprservice_connection* connection);
+bool                                       aprservice_connection_open(aprservice_connection* connection);
+void                                       aprservice_connection_close(aprservice_connection* connection);
+// @return false on connection closed
+bool                                       aprservice_connection_poll(aprservice_connection* connection);
+// @return 0 on disconnect
+// @return -1 on would block
+int                                        aprservice_connection_read(aprservice_connection* connection, void* buffer, size_t size, size_t* number_of_bytes_received);
+// @return 0 on disconnect
+// @return -1 on would block
+int                                        aprservice_connection_write(aprservice_connection* connection, const void* buffer, size_t size, size_t* number_of_bytes_sent);
+bool                                       aprservice_connection_is_airtime_limited(aprservice_connection* connection);
+void                                       aprservice_connection_airtime_refill(aprservice_connection* connection);
+// @return milliseconds until the next pending frame can be sent
+uint32_t                                   aprservice_connection_airtime_get_wait(aprservice_connection* connection);
+// moves up to APRSERVICE_CONNECTION_TX_BATCH_SIZE pending buffers to the tx queue, highest priority first
+// stops early when a kiss tnc has used up its airtime
+void                                       aprservice_connection_tx_schedule(aprservice_connection* connection);
+// writes up to APRSERVICE_CONNECTION_TX_BATCH_SIZE buffers from the front of the tx queue with one call
+// @return 0 on disconnect
+// @return -1 on would block
+int                                        aprservice_connection_write_tx_queue(aprservice_connection* connection);
+// writes until the tx queue and every pending priority is empty or the connection would block
+// @return 0 on disconnect
+// @return -1 on would block
+int                                        aprservice_connection_flush(aprservice_connection* connection);
+// value is a line from aprs-is or an ax.25 frame from a tnc
+// value is null terminated and valid until the connection is next polled
+bool                                       aprservice_connection_read_string(aprservice_connection* connection, std::string_view& value);
+// @return false on connection closed
+bool                                       aprservice_connection_encode_packet(aprservice_connection* connection, aprs_packet* packet, std::string& value);
+// @return false on connection closed
+bool                                       aprservice_connection_write_packet(aprservice_connection* connection, aprs_packet* value, APRSERVICE_PRIORITIES priority);
+// value must be encoded by aprservice_connection_encode_packet
+// key is empty or replaces a pending buffer with the same key
+// @return false on connection closed
+bool                                       aprservice_connection_write_encoded(aprservice_connection* connection, std::string&& value, APRSERVICE_PRIORITIES priority, std::string&& key);
+// @return false on connection closed
+bool                                       aprservice_connection_write_aprs_is(aprservice_connection* connection, std::string&& value);
+
+// queues service to have its fd and deadline updated before the loop next waits
+void                                       aprservice_loop_wake(aprservice* service);
+// stops waiting on the fd of service before it is closed
+void                                       aprservice_loop_unwatch(aprservice* service);
+#if defined(APRSERVICE_LOOP_IO_URING)
+// copies what a loop received for connection
+// @return 0 on disconnect
+// @return -1 on would block
+// @return -2 if connection is not read through io_uring
+int                                        aprservice_loop_io_uring_read(aprservice_connection* connection, void* buffer, size_t size, size_t* number_of_bytes_received);
+#endif
 
-	while (auto buffer = connection->tx_queue.empty() ? nullptr : &connection->tx_queue.front())
+aprservice_connection*                     aprservice_connection_init(aprservice* service, int type, const char* host_or_device, uint16_t port, uint32_t speed, uint16_t passcode)
+{
+	auto connection = new aprservice_connection
 	{
-		auto buffer_size = buffer->value.length();
+		.service        = service,
 
-		switch (aprservice_connection_write(connection, &buffer->value[buffer->offset], buffer_size - buffer->offset, &number_of_bytes_transferred))
-		{
-			case 0:  return false;
-			case -1: return true;
-		}
+		.is_open        = false,
 
-		if ((buffer->offset += number_of_bytes_transferred) == buffer_size)
-			connection->tx_queue.pop();
-	}
+		.type           = type,
 
-	switch (connection->type)
+		.io_time        = aprservice_get_time_ms(service),
+
+		.device_speed   = speed,
+		.host_or_device = host_or_device,
+		.port           = port,
+		.passcode       = passcode
+	};
+
+#if defined(APRSERVICE_WIN32)
+	if (auto error = WSAStartup(MAKEWORD(2, 2), &connection->winsock))
 	{
-		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
-			if (!aprservice_connection_poll_aprs_is(connection))
-				return false;
-			break;
+		aprservice_log_error(WSAStartup, error);
 
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
-			if (!aprservice_connection_poll_kiss_tnc(connection))
-				return false;
-			break;
+		delete connection;
+
+		return nullptr;
 	}
+#endif
 
-	if ((aprservice_get_time(connection->service) - connection->io_time) >= connection->service->connection_timeout)
-	{
+	return connection;
+}
+void                                       aprservice_connection_deinit(aprservice_connection* connection)
+{
+	if (aprservice_connection_is_open(connection))
 		aprservice_connection_close(connection);
 
-		return false;
-	}
+#if defined(APRSERVICE_WIN32)
+	WSACleanup();
+#endif
 
-	return true;
+	delete connection;
 }
-int                                        aprservice_connection_read(aprservice_connection* connection, void* buffer, size_t size, size_t* number_of_bytes_received)
+bool                                       aprservice_connection_is_open(aprservice_connection* connection)
 {
-	if (!aprservice_connection_is_open(connection))
-		return 0;
+	return connection->is_open;
+}
+bool                                       aprservice_connection_open_tcp(aprservice_connection* connection)
+{
+resolve_host:
+	addrinfo  dns_hint = { .ai_family = AF_UNSPEC };
+	addrinfo* dns_result;
 
-	switch (connection->type)
+	if (auto error = getaddrinfo(connection->host_or_device.c_str(), "", &dns_hint, &dns_result))
 	{
-		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+		switch (error)
 		{
-#if defined(APRSERVICE_UNIX)
-			ssize_t bytes_received;
+			case EAI_FAIL:
+			case EAI_AGAIN:
+			case EAI_NONAME:
+				break;
 
-			switch (bytes_received = recv(connection->socket, buffer, size, 0))
-			{
-				case 0:
-					aprservice_connection_close(connection);
-					return 0;
+			default:
+				aprservice_log_error(getaddrinfo, error);
+				break;
+		}
 
-				case -1:
-				{
-					auto error = errno;
+		return false;
+	}
 
-					switch (error)
-					{
-						case EAGAIN:
-	#if EAGAIN != EWOULDBLOCK
-						case EWOULDBLOCK:
-	#endif
-							return -1;
+	union
+	{
+		sockaddr_in  dns_result_ipv4;
+		sockaddr_in6 dns_result_ipv6;
+	};
 
-						case ECONNRESET:
-							aprservice_connection_close(connection);
-							return 0;
-					}
+	sockaddr* dns_result_address;
+	int       dns_result_address_length = 0;
 
-					aprservice_log_error(recv, error);
-					aprservice_connection_close(connection);
-				}
-				return 0;
+	switch (dns_result->ai_family)
+	{
+		case AF_INET:
+			dns_result_ipv4          = *reinterpret_cast<const sockaddr_in*>(dns_result->ai_addr);
+			dns_result_ipv4.sin_port = htons(connection->port);
+			dns_result_address        = reinterpret_cast<sockaddr*>(&dns_result_ipv4);
+			dns_result_address_length = sizeof(sockaddr_in);
+			break;
 
-				default:
-					*number_of_bytes_received = bytes_received;
-					break;
-			}
-#elif defined(APRSERVICE_WIN32)
-			int bytes_received;
+		case AF_INET6:
+			dns_result_ipv6           = *reinterpret_cast<const sockaddr_in6*>(dns_result->ai_addr);
+			dns_result_ipv6.sin6_port = htons(connection->port);
+			dns_result_address        = reinterpret_cast<sockaddr*>(&dns_result_ipv6);
+			dns_result_address_length = sizeof(sockaddr_in6);
+			break;
+	}
 
-			switch (bytes_received = recv(connection->socket, reinterpret_cast<char*>(buffer), static_cast<int>(size), 0))
-			{
-				case 0:
-					aprservice_connection_close(connection);
-					return 0;
+	freeaddrinfo(dns_result);
 
-				case SOCKET_ERROR:
-				{
-					auto error = WSAGetLastError();
+	if (!dns_result_address_length)
+		return false;
 
-					switch (error)
-					{
-						case WSAEINPROGRESS:
-						case WSAEWOULDBLOCK:
-							return -1;
+socket_open:
+#if defined(APRSERVICE_UNIX)
+	if ((connection->socket = socket(dns_result_address->sa_family, SOCK_STREAM, IPPROTO_TCP)) == -1)
+	{
+		auto error = errno;
 
-						case WSAECONNRESET:
-							aprservice_connection_close(connection);
-							return 0;
-					}
+		aprservice_log_error(socket, error);
 
-					aprservice_log_error(recv, error);
-					aprservice_connection_close(connection);
-				}
-				return 0;
+		return false;
+	}
+#elif defined(APRSERVICE_WIN32)
+	if ((connection->socket = WSASocketW(dns_result_address->sa_family, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, 0)) == INVALID_SOCKET)
+	{
+		auto error = WSAGetLastError();
 
-				default:
-					*number_of_bytes_received = bytes_received;
-					break;
-			}
+		aprservice_log_error(WSASocketW, error);
+
+		return false;
+	}
 #endif
-		}
-		break;
 
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
-		{
+socket_connect:
 #if defined(APRSERVICE_UNIX)
-			int bytes_received;
+	if (connect(connection->socket, dns_result_address, dns_result_address_length) == -1)
+	{
+		auto error = errno;
 
-			if ((bytes_received = read(connection->serial, buffer, size)) == -1)
-			{
-				auto error = errno;
+		aprservice_log_error(connect, error);
 
-				aprservice_log_error(read, error);
+		close(connection->socket);
 
-				aprservice_connection_close(connection);
+		return false;
+	}
 
-				return 0;
-			}
+	int flags;
 
-			if (bytes_received == 0)
-				return -1;
+	if ((flags = fcntl(connection->socket, F_GETFL, 0)) == -1)
+	{
+		auto error = errno;
 
-			*number_of_bytes_received = bytes_received;
-#elif defined(APRSERVICE_WIN32)
-			DWORD bytes_received;
+		aprservice_log_error(fcntl, error);
 
-			if (!ReadFile(connection->serial, &buffer, size, &bytes_received, nullptr))
-			{
-				auto error = GetLastError();
+		close(connection->socket);
 
-				aprservice_log_error(ReadFile, error);
+		return false;
+	}
 
-				aprservice_connection_close(connection);
+	flags |= O_NONBLOCK;
 
-				return 0;
-			}
+	if (fcntl(connection->socket, F_SETFL, flags) == -1)
+	{
+		auto error = errno;
 
-			if (bytes_received == 0)
-				return -1;
+		aprservice_log_error(fcntl, error);
 
-			*number_of_bytes_received = bytes_received;
-#endif
-		}
-		break;
+		close(connection->socket);
+
+		return false;
 	}
+#elif defined(APRSERVICE_WIN32)
+	if (connect(connection->socket, dns_result_address, dns_result_address_length) == SOCKET_ERROR)
+	{
+		auto error = WSAGetLastError();
 
-	connection->io_time = aprservice_get_time(connection->service);
+		aprservice_log_error(connect, error);
 
-	return 1;
-}
-int                                        aprservice_connection_write(aprservice_connection* connection, const void* buffer, size_t size, size_t* number_of_bytes_sent)
-{
-	if (!aprservice_connection_is_open(connection))
-		return 0;
+		closesocket(connection->socket);
 
-	switch (connection->type)
+		return false;
+	}
+
+	u_long arg = 1;
+
+	if (ioctlsocket(connection->socket, FIONBIO, &arg))
 	{
-		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
-		{
-#if defined(APRSERVICE_UNIX)
-			ssize_t bytes_sent;
+		auto error = WSAGetLastError();
 
-			if ((bytes_sent = send(connection->socket, buffer, size, 0)) == -1)
-			{
-				auto error = errno;
+		aprservice_log_error(ioctlsocket, error);
 
-				switch (error)
-				{
-					case EAGAIN:
-	#if EAGAIN != EWOULDBLOCK
-					case EWOULDBLOCK:
-	#endif
-						return -1;
+		closesocket(connection->socket);
 
-					case ECONNRESET:
-						aprservice_connection_close(connection);
-						return 0;
-				}
+		return false;
+	}
+#endif
 
-				aprservice_log_error(send, error);
-				aprservice_connection_close(connection);
+	connection->is_open = true;
 
-				return 0;
-			}
+	return true;
+}
+bool                                       aprservice_connection_open_serial(aprservice_connection* connection)
+{
+#if defined(APRSERVICE_UNIX)
+	if ((connection->serial = open(connection->host_or_device.c_str(), O_RDWR | O_NOCTTY)) == -1)
+	{
+		auto error = errno;
 
-			if (number_of_bytes_sent)
-				*number_of_bytes_sent = bytes_sent;
-#elif defined(APRSERVICE_WIN32)
-			int bytes_sent;
+		aprservice_log_error(open, error);
 
-			if ((bytes_sent = send(connection->socket, reinterpret_cast<const char*>(buffer), static_cast<int>(size), 0)) == SOCKET_ERROR)
-			{
-				auto error = WSAGetLastError();
+		return false;
+	}
 
-				switch (error)
-				{
-					case WSAENOBUFS:
-					case WSAEINPROGRESS:
-					case WSAEWOULDBLOCK:
-						return -1;
+	fcntl(connection->serial, F_SETFL, O_RDWR);
 
-					case WSAECONNRESET:
-						aprservice_connection_close(connection);
-						return 0;
-				}
+	termios options;
+	tcgetattr(connection->serial, &options);
+	cfmakeraw(&options);
+	cfsetspeed(&options, connection->device_speed);
 
-				aprservice_log_error(send, error);
-				aprservice_connection_close(connection);
+	options.c_cc[VMIN]  = 1;
+	options.c_cc[VTIME] = 0;
+	options.c_cflag    |= CS8;
+	options.c_cflag    |= CLOCAL | CREAD;
+	options.c_cflag    &= ~(PARENB | CSTOPB | CSIZE);
+	options.c_cflag    &= ~(ICANON | ECHO | ECHOE | ISIG | OPOST);
 
-				return 0;
-			}
+	tcsetattr(connection->serial, TCSANOW, &options);
 
-			if (number_of_bytes_sent)
-				*number_of_bytes_sent = bytes_sent;
-#endif
-		}
-		break;
+	int status;
 
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
-		{
-#if defined(APRSERVICE_UNIX)
-			int bytes_sent;
+	if (ioctl(connection->serial, TIOCMGET, &status) == -1)
+	{
+		auto error = errno;
 
-			if ((bytes_sent = write(connection->serial, buffer, size)) == -1)
-			{
-				auto error = errno;
+		aprservice_log_error(ioctl, error);
 
-				aprservice_log_error(write, error);
+		close(connection->serial);
 
-				aprservice_connection_close(connection);
+		return false;
+	}
 
-				return 0;
-			}
+	status |= TIOCM_DTR | TIOCM_RTS;
 
-			if (bytes_sent == 0)
-				return -1;
+	if (ioctl(connection->serial, TIOCMSET, &status) == -1)
+	{
+		auto error = errno;
 
-			if (number_of_bytes_sent)
-				*number_of_bytes_sent = bytes_sent;
-#elif defined(APRSERVICE_WIN32)
-			DWORD bytes_sent;
+		aprservice_log_error(ioctl, error);
 
-			if (!WriteFile(connection->serial, buffer, size, &bytes_sent, nullptr))
-			{
-				auto error = GetLastError();
+		close(connection->serial);
 
-				aprservice_log_error(WriteFile, error);
+		return false;
+	}
 
-				aprservice_connection_close(connection);
+	int flags;
 
-				return 0;
-			}
+	if ((flags = fcntl(connection->serial, F_GETFL, 0)) == -1)
+	{
+		auto error = errno;
 
-			if (bytes_sent == 0)
-				return -1;
+		aprservice_log_error(fcntl, error);
 
-			if (number_of_bytes_sent)
-				*number_of_bytes_sent = bytes_sent;
-#endif
-		}
-		break;
+		close(connection->serial);
+
+		return false;
 	}
 
-	connection->io_time = aprservice_get_time(connection->service);
+	flags |= O_NONBLOCK;
 
-	return 1;
-}
-bool                                       aprservice_connection_read_string(aprservice_connection* connection, std::string& value)
-{
-	if (!aprservice_connection_is_open(connection))
-		return false;
+	if (fcntl(connection->serial, F_SETFL, flags) == -1)
+	{
+		auto error = errno;
+
+		aprservice_log_error(fcntl, error);
+
+		close(connection->serial);
 
-	if (connection->rx_queue.empty())
 		return false;
+	}
+#elif defined(APRSERVICE_WIN32)
+	if ((connection->serial = CreateFileA(connection->host_or_device.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0)) == INVALID_HANDLE_VALUE)
+	{
+		auto error = GetLastError();
 
-	value = std::move(connection->rx_queue.front());
+		aprservice_log_error(CreateFileA, error);
 
-	connection->rx_queue.pop();
+		return false;
+	}
 
-	return true;
-}
-bool                                       aprservice_connection_write_packet(aprservice_connection* connection, aprs_packet* value)
-{
-	if (aprservice_connection_is_open(connection))
-		switch (connection->type)
-		{
-			case APRSERVICE_CONNECTION_TYPE_APRS_IS:
-				if (auto string = aprs_packet_to_string(value))
-					return aprservice_connection_write_aprs_is(connection, string);
-				break;
+	DCB dcb       = {};
+	dcb.DCBlength = sizeof(DCB);
 
-			case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
-			case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
-				// aprs_packet_to_string populates packet content
-				if (aprs_packet_to_string(value))
-				{
-					static auto packet_to_ax25   = [](aprs_packet* value)
-					{
-						auto        path         = aprs_packet_get_path(value);
-						auto        path_size    = aprs_path_get_length(path);
-						std::string content      = aprs_packet_get_content(value);
-						auto        content_size = content.length();
+	if (!GetCommState(connection->serial, &dcb))
+	{
+		auto error = GetLastError();
 
-						std::vector<uint8_t> buffer(14 + (path_size * 7) + 2 + content_size, 0);
-						static auto          buffer_encode_station = [](std::vector<uint8_t>& buffer, size_t offset, const char* station, bool repeated)
-						{
-							size_t i = 0;
-							auto   b = &buffer[offset];
-
-						encode_call:
-							for (; i < 6; ++i)
-								switch (*station)
-								{
-									case '-':
-									case '*':
-									case '\0':
-										goto encode_ssid;
-
-									default:
-										*(b++) = *(station++) << 1;
-										break;
-								}
-
-						encode_ssid:
-							for (; i < 6; ++i)
-								*(b++) = 0x40;
-
-							switch (*station)
-							{
-								case '-':
-									++station;
-									for (i = 0; i < 2; ++i)
-										if (!station[i] || repeated)
-											break;
-									*b = i ? ((aprservice_parse_uint<uint8_t>(station, i) & 0x0F) << 1) : 0;
-									if (repeated)
-										*b |= 0x80;
-									break;
-
-								case '*':
-									*b |= 0x80;
-									break;
-
-								case '\0':
-									*b  = 0;
-									break;
-							}
-						};
-						static auto          buffer_encode_path    = [](std::vector<uint8_t>& buffer, size_t offset, aprs_path* value)
-						{
-							auto path_node   = aprs_path_get(value);
-							auto path_length = aprs_path_get_length(value);
-
-							for (size_t i = 1; i <= path_length; ++i, ++path_node, offset += 7)
-							{
-								buffer_encode_station(buffer, offset, path_node->station, path_node->repeated);
-
-								if (i == path_length)
-									buffer[offset + 6] |= 0x01;
-							}
-
-							return offset;
-						};
-
-						buffer_encode_station(buffer, 0, aprs_packet_get_tocall(value), false);
-						buffer_encode_station(buffer, 7, aprs_packet_get_sender(value), false);
-						auto offset      = buffer_encode_path(buffer, 14, path);
-						buffer[offset++] = 0x03;
-						buffer[offset++] = 0xF0;
-						memcpy(&buffer[offset], content.c_str(), content_size);
-
-						return buffer;
-					};
-					static auto ax25_to_kiss_tnc = [](const uint8_t* value, size_t count)
-					{
-						std::string buffer;
+		aprservice_log_error(GetCommState, error);
 
-						buffer.reserve(1 + 1 + (count * 2) + 1);
-						buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_FRAME_END);
-						buffer.append(1, (char)KISS_TNC_COMMAND_DATA);
-						for (size_t i = 0; i < count; ++i, ++value)
-						{
-							switch (*value)
-							{
-								case KISS_TNC_SPECIAL_CHARACTER_FRAME_END:
-									buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE);
-									buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_TRANSPOSED_FRAME_END);
-									break;
-
-								case KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE:
-									buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_FRAME_ESCAPE);
-									buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_TRANSPOSED_FRAME_ESCAPE);
-									break;
-
-								default:
-									buffer.append(1, *value);
-									break;
-							}
-						}
-						buffer.append(1, (char)KISS_TNC_SPECIAL_CHARACTER_FRAME_END);
+		CloseHandle(connection->serial);
+
+		return false;
+	}
 
-						return buffer;
-					};
+	dcb.Parity   = NOPARITY;
+	dcb.fBinary  = TRUE;
+	dcb.BaudRate = connection->device_speed;
+	dcb.ByteSize = 8;
+	dcb.StopBits = ONESTOPBIT;
 
-					auto ax25 = packet_to_ax25(value);
-					auto kiss = ax25_to_kiss_tnc(ax25.data(), ax25.size());
+	if (!SetCommState(connection->serial, &dcb))
+	{
+		auto error = GetLastError();
 
-					connection->tx_queue.push({ .value = std::move(kiss), .offset = 0 });
+		aprservice_log_error(SetCommState, error);
 
-					return true;
-				}
-				break;
-		}
+		CloseHandle(connection->serial);
 
-	return false;
-}
-bool                                       aprservice_connection_write_aprs_is(aprservice_connection* connection, std::string&& value)
-{
-	if (!aprservice_connection_is_open(connection))
 		return false;
+	}
 
-	connection->tx_queue.push({ .value = std::move(value), .offset = 0 });
-	connection->tx_queue.push({ .value = "\r\n",           .offset = 0 });
+	COMMTIMEOUTS timeouts = {};
+
+	if (!SetCommTimeouts(connection->serial, &timeouts))
+	{
+		auto error = GetLastError();
+
+		aprservice_log_error(SetCommTimeouts, error);
+
+		CloseHandle(connection->serial);
+
+		return false;
+	}
+#endif
+
+	connection->is_open = true;
 
 	return true;
 }
-// @return 0 on error
-// @return -1 on timeout
-// @return -2 on connection closed
-int                                        aprservice_connection_wait_for_io(aprservice_connection* connection, uint32_t timeout)
+bool                                       aprservice_connection_open(aprservice_connection* connection)
 {
-	if (!aprservice_connection_is_open(connection))
-		return -2;
-
-	if (!connection->tx_queue.empty())
-		return 1;
-
-	bool would_block = false;
+	if (aprservice_connection_is_open(connection))
+		return false;
 
 	switch (connection->type)
 	{
 		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
 		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
-		{
-#if defined(APRSERVICE_UNIX)
-			pollfd fd = { .fd = connection->socket, .events = POLLRDNORM };
-
-			switch (poll(&fd, 1, (int)(timeout * 1000)))
+			if (!aprservice_connection_open_tcp(connection))
 			{
-				case 0:
-					would_block = true;
-					break;
+				// aprservice_log_error(aprservice_connection_open_tcp, false);
 
-				case -1:
-				{
-					auto error = errno;
+				return false;
+			}
+			break;
 
-					aprservice_log_error(poll, error);
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+			if (!aprservice_connection_open_serial(connection))
+			{
+				// aprservice_log_error(aprservice_connection_open_serial, false);
 
-					aprservice_connection_close(connection);
-				}
-				return -2;
+				return false;
 			}
-#elif defined(APRSERVICE_WIN32)
-			WSAPOLLFD fd = { .fd = connection->socket, .events = POLLRDNORM };
+			break;
+	}
 
-			switch (WSAPoll(&fd, 1, (INT)(timeout * 1000)))
-			{
-				case 0:
-					would_block = true;
-					break;
+	// the channel is assumed to be idle
+	connection->tx_airtime_tokens = APRSERVICE_CONNECTION_TX_AIRTIME_BURST * 100;
+	connection->tx_airtime_time   = aprservice_get_time_ms(connection->service);
 
-				case SOCKET_ERROR:
-				{
-					auto error = WSAGetLastError();
+	aprservice_loop_wake(connection->service);
 
-					aprservice_log_error(WSAPoll, error);
+	aprservice_event_execute(connection->service, APRSERVICE_EVENT_CONNECT, { });
 
-					aprservice_connection_close(connection);
-				}
-				return -2;
-			}
-#endif
+	static auto generate_auth_request = [](aprservice* service, uint16_t passcode)
+	{
+		std::stringstream ss;
+		ss << "user " << service->station << " pass " << (passcode ? passcode : -1);
+		ss << " vers " << APRSERVICE_SOFTWARE_NAME << ' ' << APRSERVICE_SOFTWARE_VERSION;
+		ss << " filter t/poimqstunw";
 
-			if (!would_block)
-				connection->io_time = aprservice_get_time(connection->service);
-			else if ((aprservice_get_time(connection->service) - connection->io_time) >= connection->service->connection_timeout)
+		return ss.str();
+	};
+
+	switch (connection->type)
+	{
+		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
+			if (auto auth_request = generate_auth_request(connection->service, connection->passcode); !aprservice_connection_write_aprs_is(connection, std::move(auth_request)))
 			{
+				aprservice_log_error(aprservice_connection_write_aprs_is, false);
+
 				aprservice_connection_close(connection);
 
-				return -2;
+				return false;
 			}
-		}
-		break;
+			connection->auth.state    = APRSERVICE_AUTH_STATE_SENT;
+			connection->auth.success  = false;
+			connection->auth.verified = false;
+			break;
 
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
 		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
-		{
-			char buffer;
-			static_assert(sizeof(buffer) == 1);
-
-#if defined(APRSERVICE_UNIX)
-			pollfd fd = { .fd = connection->serial, .events = POLLRDNORM };
-
-			switch (poll(&fd, 1, (int)(timeout * 1000)))
-			{
-				case 0:
-					would_block = true;
-					break;
-
-				case -1:
-				{
-					auto error = errno;
+			connection->auth.state    = APRSERVICE_AUTH_STATE_RECEIVED;
+			connection->auth.success  = true;
+			connection->auth.verified = true;
+			connection->auth.message.clear();
+			aprservice_event_execute(connection->service, APRSERVICE_EVENT_AUTHENTICATE, { .message = connection->auth.message.c_str(), .success = connection->auth.success, .verified = connection->auth.verified });
+			break;
+	}
 
-					aprservice_log_error(poll, error);
+	return true;
+}
+void                                       aprservice_connection_close(aprservice_connection* connection)
+{
+	if (aprservice_connection_is_open(connection))
+	{
+		aprservice_loop_unwatch(connection->service);
 
-					aprservice_connection_close(connection);
-				}
-				return -2;
-			}
+		switch (connection->type)
+		{
+			case APRSERVICE_CONNECTION_TYPE_APRS_IS:
+			case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+#if defined(APRSERVICE_UNIX)
+				close(connection->socket);
 #elif defined(APRSERVICE_WIN32)
-			COMMTIMEOUTS timeouts[2] = {};
+				closesocket(connection->socket);
+#endif
+				break;
 
-			if (timeout)
-			{
-				timeouts[1].ReadIntervalTimeout        = MAXDWORD;
-				timeouts[1].ReadTotalTimeoutConstant   = timeout * 1000;
-				timeouts[1].ReadTotalTimeoutMultiplier = 0;
+			case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+#if defined(APRSERVICE_UNIX)
+				close(connection->serial);
+#elif defined(APRSERVICE_WIN32)
+				CloseHandle(connection->serial);
+#endif
+				break;
+		}
 
-				if (!GetCommTimeouts(connection->serial, &timeouts[0]))
-				{
-					auto error = GetLastError();
+		aprservice_connection_rx_buffer_clear(&connection->rx_buffer);
+		aprservice_connection_kiss_deframer_reset(&connection->kiss_deframer);
 
-					aprservice_log_error(GetCommTimeouts, error);
+		aprservice_connection_rx_queue_clear(&connection->rx_queue);
 
-					return 0;
-				}
+		connection->tx_queue.clear();
 
-				if (!SetCommTimeouts(connection->serial, &timeouts[1]))
-				{
-					auto error = GetLastError();
+		for (size_t i = 0; i < APRSERVICE_PRIORITIES_COUNT; ++i)
+		{
+			connection->tx_pending[i].clear();
+			connection->tx_pending_skips[i] = 0;
+		}
 
-					aprservice_log_error(SetCommTimeouts, error);
+		connection->tx_pending_size    = 0;
+		connection->tx_pending_index.clear();
+		connection->tx_pending_airtime = 0;
 
-					aprservice_connection_close(connection);
+		connection->is_open = false;
 
-					return 0;
-				}
-			}
+		connection->auth.state = APRSERVICE_AUTH_STATE_NONE;
 
-			size_t number_of_bytes_received;
+		aprservice_event_execute(connection->service, APRSERVICE_EVENT_DISCONNECT, { });
+	}
+}
+// @return false on connection closed
+bool                                       aprservice_connection_poll_aprs_is(aprservice_connection* connection)
+{
+	size_t number_of_bytes_received;
+	size_t number_of_bytes_to_receive = connection->service->receive_buffer_size;
 
-			switch (aprservice_connection_read(connection, &buffer, sizeof(buffer), &number_of_bytes_received))
-			{
-				case 0:
-					return -2;
+read_once:
+	switch (aprservice_connection_read(connection, aprservice_connection_rx_buffer_reserve(&connection->rx_buffer, number_of_bytes_to_receive), number_of_bytes_to_receive, &number_of_bytes_received))
+	{
+		case 0:
+			return false;
 
-				case -1:
-					would_block = true;
-					break;
+		case -1:
+			break;
 
-				default:
-					if (number_of_bytes_received == sizeof(buffer))
-						connection->rx_buffer.push_back(buffer);
-					break;
-			}
+		default:
+			aprservice_connection_rx_buffer_commit(&connection->rx_buffer, number_of_bytes_received);
 
-			if (timeout && !SetCommTimeouts(connection->serial, &timeouts[0]))
+			for (std::string_view line; aprservice_connection_rx_buffer_read_line(&connection->rx_buffer, line); )
 			{
-				auto error = GetLastError();
-
-				aprservice_log_error(SetCommTimeouts, error);
+				aprservice_connection_rx_queue_push(&connection->rx_queue, line);
 
-				return 0;
+				++connection->service->receive_packet_count;
 			}
-#endif
-		}
-		break;
+			goto read_once;
 	}
 
-	return would_block ? -1 : 1;
+	return true;
 }
-
-void                                       aprservice_poll_tasks(struct aprservice* service);
-void                                       aprservice_poll_messages(struct aprservice* service);
-bool                                       aprservice_poll_connection(struct aprservice* service);
-bool                                       aprservice_send_message_ack(struct aprservice* service, const char* destination, const char* id);
-bool                                       aprservice_send_message_reject(struct aprservice* service, const char* destination, const char* id);
-bool                                       aprservice_execute_command(struct aprservice* service, struct aprs_packet* packet, const char* sender, std::string_view name, const char* args);
-
-struct aprservice*         APRSERVICE_CALL aprservice_init(const char* station, struct aprs_path* path, char symbol_table, char symbol_table_key)
+// @return false on connection closed
+bool                                       aprservice_connection_poll_kiss_tnc(aprservice_connection* connection)
 {
-	if (!station || !path)
-		return nullptr;
+	size_t number_of_bytes_received;
+	size_t number_of_bytes_to_receive = connection->service->receive_buffer_size;
 
-	auto service = new aprservice
-	{
-		.is_monitoring      = false,
+	auto deframer = &connection->kiss_deframer;
 
-		.time               = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count(),
-		.time_type          = APRS_TIME_ZULU_HMS,
+read_once:
+	switch (aprservice_connection_read(connection, aprservice_connection_rx_buffer_reserve(&connection->rx_buffer, number_of_bytes_to_receive), number_of_bytes_to_receive, &number_of_bytes_received))
+	{
+		case 0:
+			return false;
 
-		.path               = path,
-		.station            = station,
-		.connection_timeout = 2 * 60,
+		case -1:
+			break;
 
-		.command_prefix     = "."
-	};
+		default:
+			aprservice_connection_rx_buffer_commit(&connection->rx_buffer, number_of_bytes_received);
 
-	if (!(service->position = aprs_packet_position_init(station, APRSERVICE_TOCALL, path, 0, 0, 0, 0, 0, "", symbol_table, symbol_table_key, aprservice_get_time_type(service))))
-	{
-		aprservice_log_error(aprs_packet_position_init, nullptr);
+			for (auto byte : aprservice_connection_rx_buffer_get(&connection->rx_buffer))
+				if (aprservice_connection_kiss_deframer_push(deframer, (uint8_t)byte) && ((deframer->command & 0x0F) == KISS_TNC_COMMAND_DATA))
+				{
+					aprservice_connection_rx_queue_push(&connection->rx_queue, std::string_view((const char*)deframer->frame.data(), deframer->frame.size()));
 
-		delete service;
+					++connection->service->receive_packet_count;
+				}
 
-		return nullptr;
+			aprservice_connection_rx_buffer_clear(&connection->rx_buffer);
+			goto read_once;
 	}
 
-	aprs_path_add_reference(path);
-
-	return service;
+	return true;
 }
-void                       APRSERVICE_CALL aprservice_deinit(struct aprservice* service)
+bool                                       aprservice_connection_poll(aprservice_connection* connection)
 {
-	if (aprservice_is_connected(service))
-		aprservice_disconnect(service);
-
-	for (auto it = service->tasks.begin(); it != service->tasks.end(); )
-	{
-		for (auto jt = it->second.begin(); jt != it->second.end(); )
-		{
-			aprservice_task_information task =
-			{
-				.is_canceled = true,
+	if (!aprservice_connection_is_open(connection))
+		return false;
 
-				.seconds     = (*jt)->seconds,
-				.reschedule  = false
-			};
+	// input is still read when output would block
+	if (!aprservice_connection_flush(connection))
+		return false;
 
-			(*jt)->handler(service, &task, (*jt)->handler_param);
+	switch (connection->type)
+	{
+		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
+			if (!aprservice_connection_poll_aprs_is(connection))
+				return false;
+			break;
 
-			delete *jt;
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+			if (!aprservice_connection_poll_kiss_tnc(connection))
+				return false;
+			break;
+	}
+
+	if ((aprservice_get_time_ms(connection->service) - connection->io_time) >= (connection->service->connection_timeout * 1000ull))
+	{
+		aprservice_connection_close(connection);
+
+		return false;
+	}
+
+	return true;
+}
+int                                        aprservice_connection_read(aprservice_connection* connection, void* buffer, size_t size, size_t* number_of_bytes_received)
+{
+	if (!aprservice_connection_is_open(connection))
+		return 0;
+
+#if defined(APRSERVICE_LOOP_IO_URING)
+	if (auto result = aprservice_loop_io_uring_read(connection, buffer, size, number_of_bytes_received); result != -2)
+		return result;
+#endif
+
+	++connection->service->receive_syscall_count;
+
+	switch (connection->type)
+	{
+		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+		{
+#if defined(APRSERVICE_UNIX)
+			ssize_t bytes_received;
+
+			switch (bytes_received = recv(connection->socket, buffer, size, 0))
+			{
+				case 0:
+					aprservice_connection_close(connection);
+					return 0;
+
+				case -1:
+				{
+					auto error = errno;
+
+					switch (error)
+					{
+						case EAGAIN:
+	#if EAGAIN != EWOULDBLOCK
+						case EWOULDBLOCK:
+	#endif
+							return -1;
+
+						case ECONNRESET:
+							aprservice_connection_close(connection);
+							return 0;
+					}
+
+					aprservice_log_error(recv, error);
+					aprservice_connection_close(connection);
+				}
+				return 0;
+
+				default:
+					*number_of_bytes_received = bytes_received;
+					break;
+			}
+#elif defined(APRSERVICE_WIN32)
+			int bytes_received;
+
+			switch (bytes_received = recv(connection->socket, reinterpret_cast<char*>(buffer), static_cast<int>(size), 0))
+			{
+				case 0:
+					aprservice_connection_close(connection);
+					return 0;
+
+				case SOCKET_ERROR:
+				{
+					auto error = WSAGetLastError();
+
+					switch (error)
+					{
+						case WSAEINPROGRESS:
+						case WSAEWOULDBLOCK:
+							return -1;
+
+						case WSAECONNRESET:
+							aprservice_connection_close(connection);
+							return 0;
+					}
+
+					aprservice_log_error(recv, error);
+					aprservice_connection_close(connection);
+				}
+				return 0;
+
+				default:
+					*number_of_bytes_received = bytes_received;
+					break;
+			}
+#endif
+		}
+		break;
+
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+		{
+#if defined(APRSERVICE_UNIX)
+			int bytes_received;
+
+			if ((bytes_received = read(connection->serial, buffer, size)) == -1)
+			{
+				auto error = errno;
+
+				aprservice_log_error(read, error);
+
+				aprservice_connection_close(connection);
+
+				return 0;
+			}
+
+			if (bytes_received == 0)
+				return -1;
+
+			*number_of_bytes_received = bytes_received;
+#elif defined(APRSERVICE_WIN32)
+			DWORD bytes_received;
+
+			if (!ReadFile(connection->serial, &buffer, size, &bytes_received, nullptr))
+			{
+				auto error = GetLastError();
+
+				aprservice_log_error(ReadFile, error);
+
+				aprservice_connection_close(connection);
+
+				return 0;
+			}
+
+			if (bytes_received == 0)
+				return -1;
+
+			*number_of_bytes_received = bytes_received;
+#endif
+		}
+		break;
+	}
+
+	connection->io_time = aprservice_get_time_ms(connection->service);
+
+	return 1;
+}
+int                                        aprservice_connection_write(aprservice_connection* connection, const void* buffer, size_t size, size_t* number_of_bytes_sent)
+{
+	if (!aprservice_connection_is_open(connection))
+		return 0;
+
+	switch (connection->type)
+	{
+		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+		{
+#if defined(APRSERVICE_UNIX)
+			ssize_t bytes_sent;
+
+			if ((bytes_sent = send(connection->socket, buffer, size, 0)) == -1)
+			{
+				auto error = errno;
+
+				switch (error)
+				{
+					case EAGAIN:
+	#if EAGAIN != EWOULDBLOCK
+					case EWOULDBLOCK:
+	#endif
+						return -1;
+
+					case ECONNRESET:
+						aprservice_connection_close(connection);
+						return 0;
+				}
+
+				aprservice_log_error(send, error);
+				aprservice_connection_close(connection);
+
+				return 0;
+			}
+
+			if (number_of_bytes_sent)
+				*number_of_bytes_sent = bytes_sent;
+#elif defined(APRSERVICE_WIN32)
+			int bytes_sent;
+
+			if ((bytes_sent = send(connection->socket, reinterpret_cast<const char*>(buffer), static_cast<int>(size), 0)) == SOCKET_ERROR)
+			{
+				auto error = WSAGetLastError();
+
+				switch (error)
+				{
+					case WSAENOBUFS:
+					case WSAEINPROGRESS:
+					case WSAEWOULDBLOCK:
+						return -1;
+
+					case WSAECONNRESET:
+						aprservice_connection_close(connection);
+						return 0;
+				}
+
+				aprservice_log_error(send, error);
+				aprservice_connection_close(connection);
+
+				return 0;
+			}
+
+			if (number_of_bytes_sent)
+				*number_of_bytes_sent = bytes_sent;
+#endif
+		}
+		break;
+
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+		{
+#if defined(APRSERVICE_UNIX)
+			int bytes_sent;
+
+			if ((bytes_sent = write(connection->serial, buffer, size)) == -1)
+			{
+				auto error = errno;
+
+				aprservice_log_error(write, error);
+
+				aprservice_connection_close(connection);
+
+				return 0;
+			}
+
+			if (bytes_sent == 0)
+				return -1;
+
+			if (number_of_bytes_sent)
+				*number_of_bytes_sent = bytes_sent;
+#elif defined(APRSERVICE_WIN32)
+			DWORD bytes_sent;
+
+			if (!WriteFile(connection->serial, buffer, size, &bytes_sent, nullptr))
+			{
+				auto error = GetLastError();
+
+				aprservice_log_error(WriteFile, error);
+
+				aprservice_connection_close(connection);
+
+				return 0;
+			}
+
+			if (bytes_sent == 0)
+				return -1;
+
+			if (number_of_bytes_sent)
+				*number_of_bytes_sent = bytes_sent;
+#endif
+		}
+		break;
+	}
+
+	connection->io_time = aprservice_get_time_ms(connection->service);
+
+	return 1;
+}
+bool                                       aprservice_connection_is_airtime_limited(aprservice_connection* connection)
+{
+	switch (connection->type)
+	{
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+			return connection->service->kiss_baud_rate != 0;
+	}
+
+	return false;
+}
+void                                       aprservice_connection_airtime_refill(aprservice_connection* connection)
+{
+	auto time = aprservice_get_time_ms(connection->service);
+
+	connection->tx_airtime_tokens = std::min<int64_t>(connection->tx_airtime_tokens + (int64_t)((time - connection->tx_airtime_time) * connection->service->kiss_duty_cycle), APRSERVICE_CONNECTION_TX_AIRTIME_BURST * 100);
+	connection->tx_airtime_time   = time;
+}
+uint32_t                                   aprservice_connection_airtime_get_wait(aprservice_connection* connection)
+{
+	if (!connection->tx_pending_size || !aprservice_connection_is_airtime_limited(connection))
+		return 0;
+
+	aprservice_connection_airtime_refill(connection);
+
+	if (connection->tx_airtime_tokens > 0)
+		return 0;
+
+	return (uint32_t)((-connection->tx_airtime_tokens / connection->service->kiss_duty_cycle) + 1);
+}
+void                                       aprservice_connection_tx_schedule(aprservice_connection* connection)
+{
+	auto is_airtime_limited = aprservice_connection_is_airtime_limited(connection);
+
+	if (is_airtime_limited)
+		aprservice_connection_airtime_refill(connection);
+
+	while (connection->tx_pending_size && (connection->tx_queue.size() < APRSERVICE_CONNECTION_TX_BATCH_SIZE))
+	{
+		// a frame may overdraw the bucket, the next one waits until it is paid back
+		if (is_airtime_limited && (connection->tx_airtime_tokens <= 0))
+			break;
+
+		size_t priority = APRSERVICE_PRIORITIES_COUNT;
+
+		for (size_t i = 0; i < APRSERVICE_PRIORITIES_COUNT; ++i)
+			if (!connection->tx_pending[i].empty())
+			{
+				if (priority == APRSERVICE_PRIORITIES_COUNT)
+					priority = i;
+				else if (connection->tx_pending_skips[i] >= APRSERVICE_CONNECTION_TX_STARVATION_LIMIT)
+				{
+					priority = i;
+
+					break;
+				}
+			}
+
+		for (size_t i = 0; i < APRSERVICE_PRIORITIES_COUNT; ++i)
+			if ((i != priority) && !connection->tx_pending[i].empty())
+				++connection->tx_pending_skips[i];
+
+		connection->tx_pending_skips[priority] = 0;
+
+		auto buffer = &connection->tx_pending[priority].front();
+
+		if (is_airtime_limited)
+			connection->tx_airtime_tokens -= buffer->airtime * 100ll;
+
+		connection->tx_pending_airtime -= buffer->airtime;
+
+		if (!buffer->key.empty())
+			connection->tx_pending_index.erase(buffer->key);
+
+		connection->tx_queue.push_back(std::move(*buffer));
+		connection->tx_pending[priority].pop_front();
+
+		--connection->tx_pending_size;
+	}
+}
+int                                        aprservice_connection_write_tx_queue(aprservice_connection* connection)
+{
+	if (!aprservice_connection_is_open(connection))
+		return 0;
+
+	if (connection->tx_queue.empty())
+		aprservice_connection_tx_schedule(connection);
+
+	// anything still pending is waiting for airtime
+	if (connection->tx_queue.empty())
+		return connection->tx_pending_size ? -1 : 1;
+
+	size_t number_of_bytes_sent;
+	size_t number_of_buffers = 0;
+
+#if defined(APRSERVICE_UNIX)
+	iovec  buffers[APRSERVICE_CONNECTION_TX_BATCH_SIZE];
+
+	for (auto it = connection->tx_queue.begin(); (it != connection->tx_queue.end()) && (number_of_buffers < APRSERVICE_CONNECTION_TX_BATCH_SIZE); ++it, ++number_of_buffers)
+		buffers[number_of_buffers] = { .iov_base = &it->value[it->offset], .iov_len = it->value.length() - it->offset };
+#elif defined(APRSERVICE_WIN32)
+	WSABUF buffers[APRSERVICE_CONNECTION_TX_BATCH_SIZE];
+
+	for (auto it = connection->tx_queue.begin(); (it != connection->tx_queue.end()) && (number_of_buffers < APRSERVICE_CONNECTION_TX_BATCH_SIZE); ++it, ++number_of_buffers)
+		buffers[number_of_buffers] = { .len = static_cast<ULONG>(it->value.length() - it->offset), .buf = &it->value[it->offset] };
+#endif
+
+	switch (connection->type)
+	{
+		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+		{
+#if defined(APRSERVICE_UNIX)
+			msghdr  message = { .msg_iov = buffers, .msg_iovlen = number_of_buffers };
+			ssize_t bytes_sent;
+
+			if ((bytes_sent = sendmsg(connection->socket, &message, 0)) == -1)
+			{
+				auto error = errno;
+
+				switch (error)
+				{
+					case EAGAIN:
+	#if EAGAIN != EWOULDBLOCK
+					case EWOULDBLOCK:
+	#endif
+						return -1;
+
+					case ECONNRESET:
+						aprservice_connection_close(connection);
+						return 0;
+				}
+
+				aprservice_log_error(sendmsg, error);
+				aprservice_connection_close(connection);
+
+				return 0;
+			}
+
+			number_of_bytes_sent = bytes_sent;
+#elif defined(APRSERVICE_WIN32)
+			DWORD bytes_sent;
+
+			if (WSASend(connection->socket, buffers, static_cast<DWORD>(number_of_buffers), &bytes_sent, 0, nullptr, nullptr) == SOCKET_ERROR)
+			{
+				auto error = WSAGetLastError();
+
+				switch (error)
+				{
+					case WSAENOBUFS:
+					case WSAEINPROGRESS:
+					case WSAEWOULDBLOCK:
+						return -1;
+
+					case WSAECONNRESET:
+						aprservice_connection_close(connection);
+						return 0;
+				}
+
+				aprservice_log_error(WSASend, error);
+				aprservice_connection_close(connection);
+
+				return 0;
+			}
+
+			number_of_bytes_sent = bytes_sent;
+#endif
+		}
+		break;
+
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+		{
+#if defined(APRSERVICE_UNIX)
+			ssize_t bytes_sent;
+
+			if ((bytes_sent = writev(connection->serial, buffers, number_of_buffers)) == -1)
+			{
+				auto error = errno;
+
+				// the tty is opened with O_NONBLOCK, a full output buffer is not an error
+				if ((error == EAGAIN) || (error == EWOULDBLOCK))
+					return -1;
+
+				aprservice_log_error(writev, error);
+
+				aprservice_connection_close(connection);
+
+				return 0;
+			}
+
+			if (bytes_sent == 0)
+				return -1;
+
+			number_of_bytes_sent = bytes_sent;
+#elif defined(APRSERVICE_WIN32)
+			// WriteFile has no gathered form, serial ports are slow enough that this does not matter
+			switch (auto result = aprservice_connection_write(connection, buffers[0].buf, buffers[0].len, &number_of_bytes_sent))
+			{
+				case 0:
+				case -1:
+					return result;
+			}
+#endif
+		}
+		break;
+	}
+
+	connection->io_time = aprservice_get_time_ms(connection->service);
+
+	while (number_of_bytes_sent)
+	{
+		auto buffer           = &connection->tx_queue.front();
+		auto buffer_remaining = buffer->value.length() - buffer->offset;
+
+		if (number_of_bytes_sent < buffer_remaining)
+		{
+			buffer->offset += number_of_bytes_sent;
+
+			break;
+		}
+
+		number_of_bytes_sent -= buffer_remaining;
+
+		connection->tx_queue.pop_front();
+	}
+
+	return 1;
+}
+int                                        aprservice_connection_flush(aprservice_connection* connection)
+{
+	while (!connection->tx_queue.empty() || connection->tx_pending_size)
+		if (auto result = aprservice_connection_write_tx_queue(connection); result != 1)
+			return result;
+
+	return 1;
+}
+bool                                       aprservice_connection_read_string(aprservice_connection* connection, std::string_view& value)
+{
+	if (!aprservice_connection_is_open(connection))
+		return false;
+
+	return aprservice_connection_rx_queue_pop(&connection->rx_queue, value);
+}
+bool                                       aprservice_connection_encode_packet(aprservice_connection* connection, aprs_packet* packet, std::string& value)
+{
+	if (aprservice_connection_is_open(connection))
+		switch (connection->type)
+		{
+			case APRSERVICE_CONNECTION_TYPE_APRS_IS:
+				if (auto string = aprs_packet_to_string(packet))
+				{
+					value.assign(string);
+					value.append("\r\n");
+
+					return true;
+				}
+				break;
+
+			case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+			case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+				if (auto content = aprs_packet_content_to_string(packet))
+				{
+					value.clear();
+
+					aprservice_ax25_encode_packet(connection->service, connection->kiss_tx_frame, packet, content);
+					aprservice_kiss_encode_frame(value, connection->kiss_tx_frame.data(), connection->kiss_tx_frame.size());
+
+					return true;
+				}
+				break;
+		}
+
+	return false;
+}
+bool                                       aprservice_connection_write_packet(aprservice_connection* connection, aprs_packet* value, APRSERVICE_PRIORITIES priority)
+{
+	std::string buffer;
+
+	if (!aprservice_connection_encode_packet(connection, value, buffer))
+		return false;
+
+	std::string key;
+
+	// only the latest state of an item or object is worth sending, names are only unique per sender
+	switch (aprs_packet_get_type(value))
+	{
+		case APRS_PACKET_TYPE_ITEM:
+			key.append(aprs_packet_get_sender(value));
+			key.append(1, ')');
+			key.append(aprs_packet_item_get_name(value));
+			break;
+
+		case APRS_PACKET_TYPE_OBJECT:
+			key.append(aprs_packet_get_sender(value));
+			key.append(1, ';');
+			key.append(aprs_packet_object_get_name(value));
+			break;
+	}
+
+	return aprservice_connection_write_encoded(connection, std::move(buffer), priority, std::move(key));
+}
+bool                                       aprservice_connection_write_encoded(aprservice_connection* connection, std::string&& value, APRSERVICE_PRIORITIES priority, std::string&& key)
+{
+	if (!aprservice_connection_is_open(connection))
+		return false;
+
+	uint32_t airtime = 0;
+
+	switch (connection->type)
+	{
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+			airtime = aprservice_kiss_frame_get_airtime(value, connection->service->kiss_baud_rate);
+			break;
+	}
+
+	if (!key.empty())
+		if (auto it = connection->tx_pending_index.find(key); it != connection->tx_pending_index.end())
+		{
+			auto buffer = it->second;
+
+			connection->tx_pending_airtime -= buffer->airtime;
+			connection->tx_pending_airtime += airtime;
+
+			buffer->value   = std::move(value);
+			buffer->airtime = airtime;
+
+			return true;
+		}
+
+	auto buffer = &connection->tx_pending[priority].emplace_back(aprservice_connection_buffer { .value = std::move(value), .offset = 0, .airtime = airtime, .key = std::move(key) });
+
+	// deque references survive push_back and pop_front
+	if (!buffer->key.empty())
+		connection->tx_pending_index.emplace(buffer->key, buffer);
+
+	++connection->tx_pending_size;
+	connection->tx_pending_airtime += airtime;
+
+	aprservice_loop_wake(connection->service);
+
+	return true;
+}
+bool                                       aprservice_connection_write_aprs_is(aprservice_connection* connection, std::string&& value)
+{
+	if (!aprservice_connection_is_open(connection))
+		return false;
+
+	value.append("\r\n");
+
+	connection->tx_queue.push_back({ .value = std::move(value), .offset = 0 });
+
+	aprservice_loop_wake(connection->service);
+
+	return true;
+}
+// @return 0 on error
+// @return -1 on timeout
+// @return -2 on connection closed
+// @param timeout milliseconds
+int                                        aprservice_connection_wait_for_io(aprservice_connection* connection, uint32_t timeout)
+{
+	if (!aprservice_connection_is_open(connection))
+		return -2;
+
+	// anything left in the tx queue afterwards is waited on along with input
+	if (!aprservice_connection_flush(connection))
+		return -2;
+
+	// frames waiting for airtime are not writable until the wait is over
+	if (auto airtime_wait = aprservice_connection_airtime_get_wait(connection); airtime_wait && (airtime_wait < timeout))
+		timeout = airtime_wait;
+
+	bool would_block = false;
+	bool will_write  = !connection->tx_queue.empty();
+
+	switch (connection->type)
+	{
+		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+		{
+#if defined(APRSERVICE_UNIX)
+			pollfd fd = { .fd = connection->socket, .events = (short)(will_write ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM) };
+
+			switch (poll(&fd, 1, (int)timeout))
+			{
+				case 0:
+					would_block = true;
+					break;
+
+				case -1:
+				{
+					auto error = errno;
+
+					aprservice_log_error(poll, error);
+
+					aprservice_connection_close(connection);
+				}
+				return -2;
+			}
+#elif defined(APRSERVICE_WIN32)
+			WSAPOLLFD fd = { .fd = connection->socket, .events = (SHORT)(will_write ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM) };
+
+			switch (WSAPoll(&fd, 1, (INT)timeout))
+			{
+				case 0:
+					would_block = true;
+					break;
+
+				case SOCKET_ERROR:
+				{
+					auto error = WSAGetLastError();
+
+					aprservice_log_error(WSAPoll, error);
+
+					aprservice_connection_close(connection);
+				}
+				return -2;
+			}
+#endif
+
+			if ((fd.revents & POLLWRNORM) && !aprservice_connection_flush(connection))
+				return -2;
+
+			if (!would_block)
+				connection->io_time = aprservice_get_time_ms(connection->service);
+			else if ((aprservice_get_time_ms(connection->service) - connection->io_time) >= (connection->service->connection_timeout * 1000ull))
+			{
+				aprservice_connection_close(connection);
+
+				return -2;
+			}
+		}
+		break;
+
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+		{
+			char buffer;
+			static_assert(sizeof(buffer) == 1);
+
+#if defined(APRSERVICE_UNIX)
+			pollfd fd = { .fd = connection->serial, .events = (short)(will_write ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM) };
+
+			switch (poll(&fd, 1, (int)timeout))
+			{
+				case 0:
+					would_block = true;
+					break;
+
+				case -1:
+				{
+					auto error = errno;
+
+					aprservice_log_error(poll, error);
+
+					aprservice_connection_close(connection);
+				}
+				return -2;
+			}
+
+			if ((fd.revents & POLLWRNORM) && !aprservice_connection_flush(connection))
+				return -2;
+#elif defined(APRSERVICE_WIN32)
+			COMMTIMEOUTS timeouts[2] = {};
+
+			if (timeout)
+			{
+				timeouts[1].ReadIntervalTimeout        = MAXDWORD;
+				timeouts[1].ReadTotalTimeoutConstant   = timeout;
+				timeouts[1].ReadTotalTimeoutMultiplier = 0;
+
+				if (!GetCommTimeouts(connection->serial, &timeouts[0]))
+				{
+					auto error = GetLastError();
+
+					aprservice_log_error(GetCommTimeouts, error);
+
+					return 0;
+				}
+
+				if (!SetCommTimeouts(connection->serial, &timeouts[1]))
+				{
+					auto error = GetLastError();
+
+					aprservice_log_error(SetCommTimeouts, error);
+
+					aprservice_connection_close(connection);
+
+					return 0;
+				}
+			}
+
+			size_t number_of_bytes_received;
+
+			switch (aprservice_connection_read(connection, &buffer, sizeof(buffer), &number_of_bytes_received))
+			{
+				case 0:
+					return -2;
+
+				case -1:
+					would_block = true;
+					break;
+
+				default:
+					if (number_of_bytes_received == sizeof(buffer))
+						aprservice_connection_rx_buffer_write(&connection->rx_buffer, &buffer, 1);
+					break;
+			}
+
+			if (timeout && !SetCommTimeouts(connection->serial, &timeouts[0]))
+			{
+				auto error = GetLastError();
+
+				aprservice_log_error(SetCommTimeouts, error);
+
+				return 0;
+			}
+#endif
+		}
+		break;
+	}
+
+	return would_block ? -1 : 1;
+}
+
+void                                       aprservice_poll_tasks(struct aprservice* service);
+void                                       aprservice_poll_messages(struct aprservice* service);
+// cancels pending retries, executes the callback and deletes context
+void                                       aprservice_message_complete(struct aprservice* service, aprservice_message_callback_context* context, APRSERVICE_MESSAGE_ERRORS error);
+void                       APRSERVICE_CALL aprservice_message_retry(struct aprservice* service, struct aprservice_task_information* task, void* param);
+bool                                       aprservice_poll_connection(struct aprservice* service);
+APRSERVICE_PRIORITIES                      aprservice_get_packet_priority(struct aprs_packet* packet);
+bool                                       aprservice_send_message_ack(struct aprservice* service, const char* destination, const char* id);
+bool                                       aprservice_send_message_reject(struct aprservice* service, const char* destination, const char* id);
+// @return false if content does not start with prefix or has no name
+bool                                       aprservice_parse_command(std::string_view content, std::string_view prefix, std::string_view& name, const char*& args);
+bool                                       aprservice_execute_command(struct aprservice* service, struct aprs_packet* packet, const char* sender, std::string_view name, const char* args);
+// schedules the next announcement, soon after a change or at the next steady offset
+void                                       aprservice_announcer_start(struct aprservice* service, aprservice_announcer* announcer, aprservice_task_handler handler, void* param, bool is_changed);
+void                                       aprservice_announcer_stop(aprservice_announcer* announcer);
+// @return false if there is nothing left to announce
+bool                                       aprservice_announcer_update(struct aprservice* service, aprservice_announcer* announcer, struct aprservice_task_information* task, bool is_alive);
+void                       APRSERVICE_CALL aprservice_item_announcer_handler(struct aprservice* service, struct aprservice_task_information* task, void* param);
+void                       APRSERVICE_CALL aprservice_object_announcer_handler(struct aprservice* service, struct aprservice_task_information* task, void* param);
+
+struct aprservice*         APRSERVICE_CALL aprservice_init(const char* station, struct aprs_path* path, char symbol_table, char symbol_table_key)
+{
+	if (!station || !path)
+		return nullptr;
+
+	auto service = new aprservice
+	{
+		.is_monitoring           = false,
+		.is_command_case_folding = false,
+
+		.time                    = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(),
+		.time_type               = APRS_TIME_ZULU_HMS,
+
+		.path                    = path,
+		.station                 = station,
+		.connection_timeout      = 2 * 60,
+		.kiss_baud_rate          = 0,
+		.kiss_duty_cycle         = 100,
+		.receive_buffer_size     = 64 * 1024,
+		.duplicate_filter        = { .is_enabled = false, .window = 30, .max_size = 64 * 1024 },
+
+		.announce_period         = 0,
+		.announce_sequence       = 0,
+
+		.command_prefix          = ".",
+
+		.message_retry_count     = 0,
+		.message_retry_interval  = 30,
+		.message_filter          = { .is_enabled = true, .window = 5 * 60, .max_size = 4 * 1024 },
+
+		.loop_entry              = nullptr
+	};
+
+	if (!(service->position = aprs_packet_position_init(station, APRSERVICE_TOCALL, path, 0, 0, 0, 0, 0, "", symbol_table, symbol_table_key, aprservice_get_time_type(service))))
+	{
+		aprservice_log_error(aprs_packet_position_init, nullptr);
+
+		delete service;
+
+		return nullptr;
+	}
+
+	aprs_path_add_reference(path);
+
+	aprservice_ax25_header_update(service);
+	aprservice_task_wheel_init(&service->tasks);
+
+	return service;
+}
+void                       APRSERVICE_CALL aprservice_deinit(struct aprservice* service)
+{
+	if (auto loop_entry = service->loop_entry)
+		aprservice_loop_remove(loop_entry->loop, service);
+
+	if (aprservice_is_connected(service))
+		aprservice_disconnect(service);
+
+	for (auto& level : service->tasks.slots)
+		for (auto& slot : level)
+			while (slot.next != &slot)
+			{
+				auto                        task             = reinterpret_cast<aprservice_task*>(slot.next);
+				aprservice_task_information task_information =
+				{
+					.is_canceled  = true,
+
+					.seconds      = (uint32_t)(task->milliseconds / 1000),
+					.reschedule   = false,
+
+					.milliseconds = (uint32_t)std::min<uint64_t>(task->milliseconds, UINT32_MAX)
+				};
+
+				aprservice_task_link_remove(&task->link);
+
+				--service->tasks.size;
+
+				task->is_running = true;
+				task->handler(service, &task_information, task->handler_param);
+
+				delete task;
+			}
+
+	service->items.remove_if([](aprservice_item& item) {
+		aprs_packet_deinit(item.packet);
+
+		return true;
+	});
+
+	service->objects.remove_if([](aprservice_object& object) {
+		aprs_packet_deinit(object.packet);
+
+		return true;
+	});
+
+	service->commands.clear();
+
+	aprs_packet_deinit(service->position);
+	aprs_path_deinit(service->path);
+
+	delete service;
+}
+bool                       APRSERVICE_CALL aprservice_is_read_only(struct aprservice* service)
+{
+	if (aprservice_is_connected(service))
+		if (auto auth = &service->connection->auth; auth->state == APRSERVICE_AUTH_STATE_RECEIVED)
+			return !auth->success || !auth->verified;
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_is_connected(struct aprservice* service)
+{
+	return service->connection != nullptr;
+}
+bool                       APRSERVICE_CALL aprservice_is_authenticated(struct aprservice* service)
+{
+	if (aprservice_is_connected(service))
+		if (auto auth = &service->connection->auth; auth->state == APRSERVICE_AUTH_STATE_RECEIVED)
+			return auth->success && auth->verified;
+
+	return false;
+}
+bool                       APRSERVICE_CALL aprservice_is_authenticating(struct aprservice* service)
+{
+	if (aprservice_is_connected(service))
+		return service->connection->auth.state == APRSERVICE_AUTH_STATE_SENT;
+
+	return false;
+}
+bool                       APRSERVICE_CALL aprservice_is_command_case_folding_enabled(struct aprservice* service)
+{
+	return service->is_command_case_folding;
+}
+bool                       APRSERVICE_CALL aprservice_is_monitoring_enabled(struct aprservice* service)
+{
+	return service->is_monitoring;
+}
+bool                       APRSERVICE_CALL aprservice_is_compression_enabled(struct aprservice* service)
+{
+	return aprs_packet_position_is_mic_e(service->position) || aprs_packet_position_is_compressed(service->position);
+}
+bool                       APRSERVICE_CALL aprservice_is_duplicate_filter_enabled(struct aprservice* service)
+{
+	return service->duplicate_filter.is_enabled;
+}
+struct aprs_path*          APRSERVICE_CALL aprservice_get_path(struct aprservice* service)
+{
+	return service->path;
+}
+uint32_t                   APRSERVICE_CALL aprservice_get_time(struct aprservice* service)
+{
+	return (uint32_t)(aprservice_get_time_ms(service) / 1000);
+}
+uint64_t                   APRSERVICE_CALL aprservice_get_time_ms(struct aprservice* service)
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() - service->time;
+}
+int                        APRSERVICE_CALL aprservice_get_time_type(struct aprservice* service)
+{
+	return service->time_type;
+}
+const char*                APRSERVICE_CALL aprservice_get_comment(struct aprservice* service)
+{
+	return aprs_packet_position_get_comment(service->position);
+}
+const char*                APRSERVICE_CALL aprservice_get_station(struct aprservice* service)
+{
+	return service->station.c_str();
+}
+char                       APRSERVICE_CALL aprservice_get_symbol_table(struct aprservice* service)
+{
+	return aprs_packet_position_get_symbol_table(service->position);
+}
+char                       APRSERVICE_CALL aprservice_get_symbol_table_key(struct aprservice* service)
+{
+	return aprs_packet_position_get_symbol_table_key(service->position);
+}
+void                       APRSERVICE_CALL aprservice_get_position(struct aprservice* service, float* latitude, float* longitude, int32_t* altitude, uint16_t* speed, uint16_t* course)
+{
+	*speed     = aprs_packet_position_get_speed(service->position);
+	*course    = aprs_packet_position_get_course(service->position);
+	*altitude  = aprs_packet_position_get_altitude(service->position);
+	*latitude  = aprs_packet_position_get_latitude(service->position);
+	*longitude = aprs_packet_position_get_longitude(service->position);
+}
+int                        APRSERVICE_CALL aprservice_get_position_type(struct aprservice* service)
+{
+	if (aprs_packet_position_is_mic_e(service->position))
+		return APRSERVICE_POSITION_TYPE_MIC_E;
+
+	if (aprs_packet_position_is_compressed(service->position))
+		return APRSERVICE_POSITION_TYPE_POSITION_COMPRESSED;
+
+	return APRSERVICE_POSITION_TYPE_POSITION;
+}
+const char*                APRSERVICE_CALL aprservice_get_command_prefix(struct aprservice* service)
+{
+	return service->command_prefix.c_str();
+}
+uint32_t                   APRSERVICE_CALL aprservice_get_connection_timeout(struct aprservice* service)
+{
+	return service->connection_timeout;
+}
+uint32_t                   APRSERVICE_CALL aprservice_get_announce_period(struct aprservice* service)
+{
+	return service->announce_period;
+}
+uint32_t                   APRSERVICE_CALL aprservice_get_kiss_baud_rate(struct aprservice* service)
+{
+	return service->kiss_baud_rate;
+}
+uint8_t                    APRSERVICE_CALL aprservice_get_kiss_duty_cycle(struct aprservice* service)
+{
+	return service->kiss_duty_cycle;
+}
+size_t                     APRSERVICE_CALL aprservice_get_tx_queue_depth(struct aprservice* service)
+{
+	if (!aprservice_is_connected(service))
+		return 0;
+
+	return service->connection->tx_queue.size() + service->connection->tx_pending_size;
+}
+uint64_t                   APRSERVICE_CALL aprservice_get_tx_pending_airtime(struct aprservice* service)
+{
+	if (!aprservice_is_connected(service))
+		return 0;
+
+	return service->connection->tx_pending_airtime;
+}
+uint8_t                    APRSERVICE_CALL aprservice_get_message_retry_count(struct aprservice* service)
+{
+	return service->message_retry_count;
+}
+uint32_t                   APRSERVICE_CALL aprservice_get_message_retry_interval(struct aprservice* service)
+{
+	return service->message_retry_interval;
+}
+uint32_t                   APRSERVICE_CALL aprservice_get_message_filter_window(struct aprservice* service)
+{
+	return service->message_filter.window;
+}
+uint64_t                   APRSERVICE_CALL aprservice_get_message_filter_drop_count(struct aprservice* service)
+{
+	return service->message_filter.drop_count;
+}
+uint32_t                   APRSERVICE_CALL aprservice_get_duplicate_filter_window(struct aprservice* service)
+{
+	return service->duplicate_filter.window;
+}
+uint64_t                   APRSERVICE_CALL aprservice_get_duplicate_filter_drop_count(struct aprservice* service)
+{
+	return service->duplicate_filter.drop_count;
+}
+size_t                     APRSERVICE_CALL aprservice_get_receive_buffer_size(struct aprservice* service)
+{
+	return service->receive_buffer_size;
+}
+uint64_t                   APRSERVICE_CALL aprservice_get_receive_packet_count(struct aprservice* service)
+{
+	return service->receive_packet_count;
+}
+uint64_t                   APRSERVICE_CALL aprservice_get_receive_syscall_count(struct aprservice* service)
+{
+	return service->receive_syscall_count;
+}
+bool                       APRSERVICE_CALL aprservice_get_event_handler(struct aprservice* service, enum APRSERVICE_EVENTS event, aprservice_event_handler* handler, void** param)
+{
+	if (event >= APRSERVICE_EVENTS_COUNT)
+		return false;
+
+	auto context = &service->events[event];
+
+	*handler = context->handler;
+	*param   = context->handler_param;
+
+	return true;
+}
+void                       APRSERVICE_CALL aprservice_get_default_event_handler(struct aprservice* service, aprservice_event_handler* handler, void** param)
+{
+	auto context = &service->events[APRSERVICE_EVENTS_COUNT];
+
+	*handler = context->handler;
+	*param   = context->handler_param;
+}
+bool                       APRSERVICE_CALL aprservice_set_path(struct aprservice* service, struct aprs_path* value)
+{
+	if (!value)
+		return false;
+
+	aprs_path_deinit(service->path);
+
+	service->path = value;
+
+	aprs_path_add_reference(value);
+
+	aprservice_ax25_header_update(service);
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_set_time_type(struct aprservice* service, int value)
+{
+	if (!aprs_time_type_is_valid(value))
+		return false;
+
+	service->time_type = value;
+	service->objects;
+	service->position;
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_set_symbol(struct aprservice* service, char table, char key)
+{
+	if (!aprs_packet_position_set_symbol(service->position, table, key))
+	{
+		aprservice_log_error(aprs_packet_position_set_symbol, false);
+
+		return false;
+	}
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_set_comment(struct aprservice* service, const char* value)
+{
+	if (!aprs_packet_position_set_comment(service->position, value))
+	{
+		aprservice_log_error(aprs_packet_position_set_comment, false);
+
+		return false;
+	}
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_set_position(struct aprservice* service, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course)
+{
+	if (!aprs_packet_position_set_speed(service->position, speed))
+	{
+		aprservice_log_error(aprs_packet_position_set_speed, false);
+
+		return false;
+	}
+
+	if (!aprs_packet_position_set_course(service->position, course))
+	{
+		aprservice_log_error(aprs_packet_position_set_course, false);
+
+		return false;
+	}
+
+	if (!aprs_packet_position_set_altitude(service->position, altitude))
+	{
+		aprservice_log_error(aprs_packet_position_set_altitude, false);
+
+		return false;
+	}
+
+	if (!aprs_packet_position_set_latitude(service->position, latitude))
+	{
+		aprservice_log_error(aprs_packet_position_set_latitude, false);
+
+		return false;
+	}
+
+	if (!aprs_packet_position_set_longitude(service->position, longitude))
+	{
+		aprservice_log_error(aprs_packet_position_set_longitude, false);
+
+		return false;
+	}
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_set_position_type(struct aprservice* service, enum APRSERVICE_POSITION_TYPES value)
+{
+	if (value >= APRSERVICE_POSITION_TYPES_COUNT)
+		return false;
+
+	switch (value)
+	{
+		case APRSERVICE_POSITION_TYPE_MIC_E:
+			if (auto packet = aprs_packet_position_init_mic_e(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), aprs_packet_position_get_latitude(service->position), aprs_packet_position_get_longitude(service->position), aprs_packet_position_get_altitude(service->position), aprs_packet_position_get_speed(service->position), aprs_packet_position_get_course(service->position), aprs_packet_position_get_comment(service->position), aprs_packet_position_get_symbol_table(service->position), aprs_packet_position_get_symbol_table_key(service->position), APRS_MIC_E_MESSAGE_OFF_DUTY))
+			{
+				aprs_packet_deinit(service->position);
+
+				service->position = packet;
+
+				return true;
+			}
+			aprservice_log_error(aprs_packet_position_init_mic_e, nullptr);
+			return false;
+
+		case APRSERVICE_POSITION_TYPE_POSITION:
+			if (auto packet = aprs_packet_position_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), aprs_packet_position_get_latitude(service->position), aprs_packet_position_get_longitude(service->position), aprs_packet_position_get_altitude(service->position), aprs_packet_position_get_speed(service->position), aprs_packet_position_get_course(service->position), aprs_packet_position_get_comment(service->position), aprs_packet_position_get_symbol_table(service->position), aprs_packet_position_get_symbol_table_key(service->position), aprservice_get_time_type(service)))
+			{
+				aprs_packet_deinit(service->position);
+
+				service->position = packet;
+
+				return true;
+			}
+			aprservice_log_error(aprs_packet_position_init, nullptr);
+			return false;
+
+		case APRSERVICE_POSITION_TYPE_POSITION_COMPRESSED:
+			if (auto packet = aprs_packet_position_init_compressed(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), aprs_packet_position_get_latitude(service->position), aprs_packet_position_get_longitude(service->position), aprs_packet_position_get_altitude(service->position), aprs_packet_position_get_speed(service->position), aprs_packet_position_get_course(service->position), aprs_packet_position_get_comment(service->position), aprs_packet_position_get_symbol_table(service->position), aprs_packet_position_get_symbol_table_key(service->position), aprservice_get_time_type(service)))
+			{
+				aprs_packet_deinit(service->position);
+
+				service->position = packet;
+
+				return true;
+			}
+			aprservice_log_error(aprs_packet_position_init_compressed, nullptr);
+			return false;
+	}
+
+	return false;
+}
+bool                       APRSERVICE_CALL aprservice_set_event_handler(struct aprservice* service, enum APRSERVICE_EVENTS event, aprservice_event_handler handler, void* param)
+{
+	if (event >= APRSERVICE_EVENTS_COUNT)
+		return false;
+
+	service->events[event] = { .handler = handler, .handler_param = param };
+
+	return true;
+}
+void                       APRSERVICE_CALL aprservice_set_default_event_handler(struct aprservice* service, aprservice_event_handler handler, void* param)
+{
+	service->events[APRSERVICE_EVENTS_COUNT] = { .handler = handler, .handler_param = param };
+}
+void                       APRSERVICE_CALL aprservice_set_command_prefix(struct aprservice* service, const char* value)
+{
+	if (!value)
+		service->command_prefix.clear();
+	else
+		service->command_prefix = value;
+}
+void                       APRSERVICE_CALL aprservice_set_connection_timeout(struct aprservice* service, uint32_t seconds)
+{
+	service->connection_timeout = seconds;
+}
+void                       APRSERVICE_CALL aprservice_set_announce_period(struct aprservice* service, uint32_t seconds)
+{
+	service->announce_period = std::min<uint32_t>(seconds, UINT32_MAX / 1000);
+
+	for (auto& item : service->items)
+		if (aprservice_item_is_alive(&item))
+			aprservice_announcer_start(service, &item.announcer, &aprservice_item_announcer_handler, &item, false);
+		else
+			aprservice_announcer_stop(&item.announcer);
+
+	for (auto& object : service->objects)
+		if (aprservice_object_is_alive(&object))
+			aprservice_announcer_start(service, &object.announcer, &aprservice_object_announcer_handler, &object, false);
+		else
+			aprservice_announcer_stop(&object.announcer);
+}
+void                       APRSERVICE_CALL aprservice_set_kiss_baud_rate(struct aprservice* service, uint32_t value)
+{
+	service->kiss_baud_rate = value;
+}
+bool                       APRSERVICE_CALL aprservice_set_kiss_duty_cycle(struct aprservice* service, uint8_t percent)
+{
+	if (!percent || (percent > 100))
+		return false;
+
+	service->kiss_duty_cycle = percent;
+
+	return true;
+}
+void                       APRSERVICE_CALL aprservice_set_message_retry_count(struct aprservice* service, uint8_t value)
+{
+	// attempts counts the first send as well
+	service->message_retry_count = std::min<uint8_t>(value, UINT8_MAX - 1);
+}
+void                       APRSERVICE_CALL aprservice_set_message_retry_interval(struct aprservice* service, uint32_t seconds)
+{
+	service->message_retry_interval = seconds;
+}
+void                       APRSERVICE_CALL aprservice_set_message_filter_window(struct aprservice* service, uint32_t seconds)
+{
+	service->message_filter.window = seconds;
+}
+void                       APRSERVICE_CALL aprservice_set_duplicate_filter_window(struct aprservice* service, uint32_t seconds)
+{
+	service->duplicate_filter.window = seconds;
+}
+bool                       APRSERVICE_CALL aprservice_set_receive_buffer_size(struct aprservice* service, size_t value)
+{
+	if (!value)
+		return false;
+
+	service->receive_buffer_size = value;
+
+	return true;
+}
+void                       APRSERVICE_CALL aprservice_enable_command_case_folding(struct aprservice* service, bool value)
+{
+	service->is_command_case_folding = value;
+}
+void                       APRSERVICE_CALL aprservice_enable_monitoring(struct aprservice* service, bool value)
+{
+	service->is_monitoring = value;
+}
+void                       APRSERVICE_CALL aprservice_enable_duplicate_filter(struct aprservice* service, bool value)
+{
+	if (!(service->duplicate_filter.is_enabled = value))
+	{
+		service->duplicate_filter.size = 0;
+		service->duplicate_filter.entries.clear();
+	}
+}
+bool                       APRSERVICE_CALL aprservice_poll(struct aprservice* service)
+{
+	aprservice_poll_tasks(service);
+	aprservice_poll_messages(service);
+
+	if (aprservice_is_connected(service) && !aprservice_poll_connection(service))
+		;
+
+	return true;
+}
+void                                       aprservice_poll_tasks(struct aprservice* service)
+{
+	auto wheel = &service->tasks;
+	auto time  = aprservice_get_time_ms(service);
+
+	while (wheel->time <= time)
+	{
+		if (!wheel->size)
+		{
+			wheel->time = time + 1;
+
+			break;
+		}
+
+		aprservice_task_link expired;
+
+		aprservice_task_link_init(&expired);
+		aprservice_task_wheel_advance(wheel, &expired);
+
+		while (expired.next != &expired)
+		{
+			auto                        task             = reinterpret_cast<aprservice_task*>(expired.next);
+			aprservice_task_information task_information =
+			{
+				.is_canceled  = false,
+
+				.seconds      = (uint32_t)(task->milliseconds / 1000),
+				.reschedule   = false,
+
+				.milliseconds = (uint32_t)std::min<uint64_t>(task->milliseconds, UINT32_MAX)
+			};
+
+			aprservice_task_link_remove(&task->link);
+
+			--wheel->size;
+
+			task->is_running = true;
+			task->handler(service, &task_information, task->handler_param);
+			task->is_running = false;
+
+			if (task->is_canceled || !task_information.reschedule)
+				delete task;
+			else
+			{
+				if (task->is_milliseconds)
+					task->milliseconds = task_information.milliseconds;
+				else
+					task->milliseconds = task_information.seconds * 1000ull;
+
+				task->time = aprservice_get_time_ms(service) + task->milliseconds;
+
+				aprservice_task_wheel_insert(wheel, task);
+
+				++wheel->size;
+			}
+		}
+	}
+}
+void                                       aprservice_poll_messages(struct aprservice* service)
+{
+	while (auto context = aprservice_message_callback_queue_pop(&service->message_callbacks, aprservice_get_time_ms(service)))
+		aprservice_message_complete(service, context, APRSERVICE_MESSAGE_ERROR_TIMEOUT);
+}
+void                                       aprservice_message_complete(struct aprservice* service, aprservice_message_callback_context* context, APRSERVICE_MESSAGE_ERRORS error)
+{
+	if (context->task)
+		aprservice_task_cancel(context->task);
+
+	context->callback(service, error, context->attempts, context->callback_param);
+
+	delete context;
+}
+void                       APRSERVICE_CALL aprservice_message_retry(struct aprservice* service, struct aprservice_task_information* task, void* param)
+{
+	auto context = (aprservice_message_callback_context*)param;
+
+	if (task->is_canceled)
+		return;
+
+	if (!aprservice_connection_write_encoded(service->connection, std::string(context->line), APRSERVICE_PRIORITY_MESSAGE, {}))
+	{
+		aprservice_log_error(aprservice_connection_write_encoded, false);
+
+		context->task = nullptr;
+
+		return;
+	}
+
+	// compared before the increment so attempts can not wrap
+	if (context->attempts++ >= service->message_retry_count)
+		context->task = nullptr;
+	else
+	{
+		// each retry waits twice as long as the one before it
+		task->milliseconds = (uint32_t)std::min<uint64_t>((service->message_retry_interval * 1000ull) << std::min(context->attempts - 1, 16), UINT32_MAX);
+		task->reschedule   = true;
+	}
+}
+bool                                       aprservice_poll_connection(struct aprservice* service)
+{
+	static auto on_receive_packet = [](aprservice* service, aprs_packet* packet, aprservice_connection* connection)
+	{
+		auto packet_type   = aprs_packet_get_type(packet);
+		auto packet_sender = aprs_packet_get_sender(packet);
+
+		aprservice_event_execute(service, APRSERVICE_EVENT_RECEIVE_PACKET, { .packet = packet });
+
+		if (packet_type == APRS_PACKET_TYPE_MESSAGE)
+		{
+			auto packet_message_id          = aprs_packet_message_get_id(packet);
+			auto packet_message_type        = aprs_packet_message_get_type(packet);
+			auto packet_message_content     = aprs_packet_message_get_content(packet);
+			auto packet_message_destination = aprs_packet_message_get_destination(packet);
+
+			switch (packet_message_type)
+			{
+				case APRS_MESSAGE_TYPE_ACK:
+				case APRS_MESSAGE_TYPE_REJECT:
+					if (packet_message_id && !stricmp(aprservice_get_station(service), packet_message_destination))
+						if (auto context = aprservice_message_callback_queue_find(&service->message_callbacks, packet_sender, packet_message_id))
+						{
+							aprservice_message_callback_queue_remove(&service->message_callbacks, context);
+							aprservice_message_complete(service, context, (packet_message_type == APRS_MESSAGE_TYPE_ACK) ? APRSERVICE_MESSAGE_ERROR_SUCCESS : APRSERVICE_MESSAGE_ERROR_REJECTED);
+						}
+					break;
+
+				case APRS_MESSAGE_TYPE_MESSAGE:
+					if (stricmp(aprservice_get_station(service), packet_message_destination))
+					{
+						if (aprservice_is_monitoring_enabled(service))
+							aprservice_event_execute(service, APRSERVICE_EVENT_RECEIVE_MESSAGE, { .packet = packet, .id = packet_message_id, .sender = packet_sender, .content = packet_message_content, .destination = packet_message_destination });
+					}
+					else
+					{
+						if (packet_message_id)
+						{
+							aprservice_send_message_ack(service, packet_sender, packet_message_id);
+
+							// the sender retransmits until it hears an ack, only the first copy is dispatched
+							if (aprservice_duplicate_filter_check(&service->message_filter, aprservice_duplicate_filter_hash(packet_sender, {}, packet_message_id), aprservice_get_time(service)))
+								break;
+						}
+
+						std::string_view command_name;
+						const char*      command_args;
+
+						if (!aprservice_parse_command(packet_message_content, service->command_prefix, command_name, command_args) || !aprservice_execute_command(service, packet, packet_sender, command_name, command_args))
+							aprservice_event_execute(service, APRSERVICE_EVENT_RECEIVE_MESSAGE, { .packet = packet, .id = packet_message_id, .sender = packet_sender, .content = packet_message_content, .destination = packet_message_destination });
+					}
+					break;
+			}
+		}
+	};
+
+	if (!aprservice_connection_poll(service->connection))
+	{
+		aprservice_disconnect(service);
+
+		return false;
+	}
+
+	std::string_view line;
+	std::string_view frame;
+
+	switch (service->connection->type)
+	{
+		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
+			while (aprservice_connection_read_string(service->connection, line))
+				if (line.starts_with("# "))
+				{
+					if ((service->connection->auth.state == APRSERVICE_AUTH_STATE_SENT) && aprservice_connection_auth_from_string(&service->connection->auth, &line[2], service->connection->passcode != 0))
+						aprservice_event_execute(service, APRSERVICE_EVENT_AUTHENTICATE, { .message = service->connection->auth.message.c_str(), .success = service->connection->auth.success, .verified = service->connection->auth.verified });
+					else
+						aprservice_event_execute(service, APRSERVICE_EVENT_RECEIVE_SERVER_MESSAGE, { .content = &line[2] });
+				}
+				else if (aprservice_duplicate_filter_check(service, line))
+					continue;
+				else if (auto packet = aprs_packet_init_from_string(line.data()))
+				{
+					on_receive_packet(service, packet, service->connection);
+
+					aprs_packet_deinit(packet);
+				}
+			break;
+
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
+		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
+			while (aprservice_connection_read_string(service->connection, frame))
+				if (aprservice_duplicate_filter_check(service, (const uint8_t*)frame.data(), frame.length()))
+					continue;
+				else if (auto packet = aprs_packet_init_from_ax25((const uint8_t*)frame.data(), frame.length()))
+				{
+					on_receive_packet(service, packet, service->connection);
+
+					aprs_packet_deinit(packet);
+				}
+			break;
+	}
+
+	if (!aprservice_connection_is_open(service->connection))
+	{
+		aprservice_disconnect(service);
+
+		return false;
+	}
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_send(struct aprservice* service, struct aprs_packet* packet)
+{
+	return aprservice_send_ex(service, packet, aprservice_get_packet_priority(packet));
+}
+bool                       APRSERVICE_CALL aprservice_send_ex(struct aprservice* service, struct aprs_packet* packet, enum APRSERVICE_PRIORITIES priority)
+{
+	if (priority >= APRSERVICE_PRIORITIES_COUNT)
+		return false;
+
+	if (!aprservice_connection_write_packet(service->connection, packet, priority))
+	{
+		aprservice_log_error(aprservice_connection_write_packet, false);
+
+		return false;
+	}
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_send_raw(struct aprservice* service, const char* content)
+{
+	if (!aprservice_is_connected(service))
+		return false;
+
+	if (aprservice_is_read_only(service))
+		return false;
+
+	aprs_packet* packet;
+
+	if (!(packet = aprs_packet_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service))))
+	{
+		aprservice_log_error(aprs_packet_init, nullptr);
+
+		return false;
+	}
+
+	if (!aprservice_send(service, packet))
+	{
+		aprservice_log_error(aprservice_send, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	aprs_packet_deinit(packet);
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_send_item(struct aprservice* service, const char* name, const char* comment, char symbol_table, char symbol_table_key, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course, bool live)
+{
+	if (!aprservice_is_connected(service))
+		return false;
+
+	if (aprservice_is_read_only(service))
+		return false;
+
+	aprs_packet* packet;
+
+	if (!(packet = aprs_packet_item_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), name, symbol_table, symbol_table_key)))
+	{
+		aprservice_log_error(aprs_packet_item_init, nullptr);
+
+		return false;
+	}
+
+	if (!aprs_packet_item_set_alive(packet, live))
+	{
+		aprservice_log_error(aprs_packet_item_set_alive, false);
+
+		aprs_packet_deinit(packet);
 
-			it->second.erase(jt++);
-		}
+		return false;
+	}
+
+	if (!aprs_packet_item_set_speed(packet, speed))
+	{
+		aprservice_log_error(aprs_packet_item_set_speed, false);
 
-		service->tasks.erase(it++);
+		aprs_packet_deinit(packet);
+
+		return false;
 	}
 
-	service->items.remove_if([](aprservice_item& item) {
-		aprs_packet_deinit(item.packet);
+	if (!aprs_packet_item_set_course(packet, course))
+	{
+		aprservice_log_error(aprs_packet_item_set_course, false);
 
-		return true;
-	});
+		aprs_packet_deinit(packet);
 
-	service->objects.remove_if([](aprservice_object& object) {
-		aprs_packet_deinit(object.packet);
+		return false;
+	}
 
-		return true;
-	});
+	if (!aprs_packet_item_set_comment(packet, comment))
+	{
+		aprservice_log_error(aprs_packet_item_set_comment, false);
 
-	for (auto it = service->commands.begin(); it != service->commands.end(); )
-		aprservice_command_unregister(&*it++);
+		aprs_packet_deinit(packet);
 
-	aprs_packet_deinit(service->position);
-	aprs_path_deinit(service->path);
+		return false;
+	}
 
-	delete service;
-}
-bool                       APRSERVICE_CALL aprservice_is_read_only(struct aprservice* service)
-{
-	if (aprservice_is_connected(service))
-		if (auto auth = &service->connection->auth; auth->state == APRSERVICE_AUTH_STATE_RECEIVED)
-			return !auth->success || !auth->verified;
+	if (!aprs_packet_item_set_altitude(packet, altitude))
+	{
+		aprservice_log_error(aprs_packet_item_set_altitude, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_item_set_latitude(packet, latitude))
+	{
+		aprservice_log_error(aprs_packet_item_set_latitude, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_item_set_longitude(packet, longitude))
+	{
+		aprservice_log_error(aprs_packet_item_set_longitude, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_item_set_compressed(packet, aprservice_is_compression_enabled(service)))
+	{
+		aprservice_log_error(aprs_packet_item_set_compressed, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprservice_send(service, packet))
+	{
+		aprservice_log_error(aprservice_send, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	aprs_packet_deinit(packet);
 
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_is_connected(struct aprservice* service)
-{
-	return service->connection != nullptr;
-}
-bool                       APRSERVICE_CALL aprservice_is_authenticated(struct aprservice* service)
+bool                       APRSERVICE_CALL aprservice_send_object(struct aprservice* service, const char* name, const char* comment, char symbol_table, char symbol_table_key, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course, bool live)
 {
-	if (aprservice_is_connected(service))
-		if (auto auth = &service->connection->auth; auth->state == APRSERVICE_AUTH_STATE_RECEIVED)
-			return auth->success && auth->verified;
+	if (!aprservice_is_connected(service))
+		return false;
 
-	return false;
-}
-bool                       APRSERVICE_CALL aprservice_is_authenticating(struct aprservice* service)
-{
-	if (aprservice_is_connected(service))
-		return service->connection->auth.state == APRSERVICE_AUTH_STATE_SENT;
+	if (aprservice_is_read_only(service))
+		return false;
 
-	return false;
-}
-bool                       APRSERVICE_CALL aprservice_is_monitoring_enabled(struct aprservice* service)
-{
-	return service->is_monitoring;
-}
-bool                       APRSERVICE_CALL aprservice_is_compression_enabled(struct aprservice* service)
-{
-	return aprs_packet_position_is_mic_e(service->position) || aprs_packet_position_is_compressed(service->position);
-}
-struct aprs_path*          APRSERVICE_CALL aprservice_get_path(struct aprservice* service)
-{
-	return service->path;
-}
-uint32_t                   APRSERVICE_CALL aprservice_get_time(struct aprservice* service)
-{
-	return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count() - service->time;
-}
-int                        APRSERVICE_CALL aprservice_get_time_type(struct aprservice* service)
-{
-	return service->time_type;
-}
-const char*                APRSERVICE_CALL aprservice_get_comment(struct aprservice* service)
-{
-	return aprs_packet_position_get_comment(service->position);
-}
-const char*                APRSERVICE_CALL aprservice_get_station(struct aprservice* service)
-{
-	return service->station.c_str();
-}
-char                       APRSERVICE_CALL aprservice_get_symbol_table(struct aprservice* service)
-{
-	return aprs_packet_position_get_symbol_table(service->position);
-}
-char                       APRSERVICE_CALL aprservice_get_symbol_table_key(struct aprservice* service)
-{
-	return aprs_packet_position_get_symbol_table_key(service->position);
-}
-void                       APRSERVICE_CALL aprservice_get_position(struct aprservice* service, float* latitude, float* longitude, int32_t* altitude, uint16_t* speed, uint16_t* course)
-{
-	*speed     = aprs_packet_position_get_speed(service->position);
-	*course    = aprs_packet_position_get_course(service->position);
-	*altitude  = aprs_packet_position_get_altitude(service->position);
-	*latitude  = aprs_packet_position_get_latitude(service->position);
-	*longitude = aprs_packet_position_get_longitude(service->position);
-}
-int                        APRSERVICE_CALL aprservice_get_position_type(struct aprservice* service)
-{
-	if (aprs_packet_position_is_mic_e(service->position))
-		return APRSERVICE_POSITION_TYPE_MIC_E;
+	aprs_packet* packet;
 
-	if (aprs_packet_position_is_compressed(service->position))
-		return APRSERVICE_POSITION_TYPE_POSITION_COMPRESSED;
+	if (!(packet = aprs_packet_object_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), name, symbol_table, symbol_table_key, aprservice_get_time_type(service))))
+	{
+		aprservice_log_error(aprs_packet_object_init, nullptr);
 
-	return APRSERVICE_POSITION_TYPE_POSITION;
-}
-const char*                APRSERVICE_CALL aprservice_get_command_prefix(struct aprservice* service)
-{
-	return service->command_prefix.c_str();
-}
-uint32_t                   APRSERVICE_CALL aprservice_get_connection_timeout(struct aprservice* service)
-{
-	return service->connection_timeout;
+		return false;
+	}
+
+	if (!aprs_packet_object_set_alive(packet, live))
+	{
+		aprservice_log_error(aprs_packet_object_set_alive, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_object_set_speed(packet, speed))
+	{
+		aprservice_log_error(aprs_packet_object_set_speed, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_object_set_course(packet, course))
+	{
+		aprservice_log_error(aprs_packet_object_set_course, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_object_set_comment(packet, comment))
+	{
+		aprservice_log_error(aprs_packet_object_set_comment, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_object_set_altitude(packet, altitude))
+	{
+		aprservice_log_error(aprs_packet_object_set_altitude, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_object_set_latitude(packet, latitude))
+	{
+		aprservice_log_error(aprs_packet_object_set_latitude, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_object_set_longitude(packet, longitude))
+	{
+		aprservice_log_error(aprs_packet_object_set_longitude, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprs_packet_object_set_compressed(packet, aprservice_is_compression_enabled(service)))
+	{
+		aprservice_log_error(aprs_packet_object_set_compressed, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprservice_send(service, packet))
+	{
+		aprservice_log_error(aprservice_send, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	aprs_packet_deinit(packet);
+
+	return true;
 }
-bool                       APRSERVICE_CALL aprservice_get_event_handler(struct aprservice* service, enum APRSERVICE_EVENTS event, aprservice_event_handler* handler, void** param)
+bool                       APRSERVICE_CALL aprservice_send_status(struct aprservice* service, const char* message)
 {
-	if (event >= APRSERVICE_EVENTS_COUNT)
+	if (!aprservice_is_connected(service))
 		return false;
 
-	auto context = &service->events[event];
+	if (aprservice_is_read_only(service))
+		return false;
 
-	*handler = context->handler;
-	*param   = context->handler_param;
+	aprs_packet* packet;
 
-	return true;
-}
-void                       APRSERVICE_CALL aprservice_get_default_event_handler(struct aprservice* service, aprservice_event_handler* handler, void** param)
-{
-	auto context = &service->events[APRSERVICE_EVENTS_COUNT];
+	if (!(packet = aprs_packet_status_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), message)))
+	{
+		aprservice_log_error(aprs_packet_status_init, nullptr);
 
-	*handler = context->handler;
-	*param   = context->handler_param;
-}
-bool                       APRSERVICE_CALL aprservice_set_path(struct aprservice* service, struct aprs_path* value)
-{
-	if (!value)
 		return false;
+	}
 
-	aprs_path_deinit(service->path);
+	aprs_time time;
 
-	service->path = value;
+	if (!aprs_time_now(&time, aprservice_get_time_type(service)))
+	{
+		aprservice_log_error(aprs_time_now, false);
 
-	aprs_path_add_reference(value);
+		aprs_packet_deinit(packet);
 
-	return true;
-}
-bool                       APRSERVICE_CALL aprservice_set_time_type(struct aprservice* service, int value)
-{
-	if (!aprs_time_type_is_valid(value))
 		return false;
+	}
 
-	service->time_type = value;
-	service->objects;
-	service->position;
+	if (!aprs_packet_status_set_time(packet, &time))
+	{
+		aprservice_log_error(aprs_packet_status_set_time, false);
 
-	return true;
-}
-bool                       APRSERVICE_CALL aprservice_set_symbol(struct aprservice* service, char table, char key)
-{
-	if (!aprs_packet_position_set_symbol(service->position, table, key))
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	if (!aprservice_send(service, packet))
 	{
-		aprservice_log_error(aprs_packet_position_set_symbol, false);
+		aprservice_log_error(aprservice_send, false);
+
+		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
+	aprs_packet_deinit(packet);
+
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_set_comment(struct aprservice* service, const char* value)
+bool                       APRSERVICE_CALL aprservice_send_message(struct aprservice* service, const char* destination, const char* content, uint32_t timeout, aprservice_message_callback callback, void* param)
 {
-	if (!aprs_packet_position_set_comment(service->position, value))
+	char id[6] = {};
+
+	if (service->message_count == 0)
+		id[0] = '0';
+	else
 	{
-		aprservice_log_error(aprs_packet_position_set_comment, false);
+		static constexpr char BASE62[] =
+		{
+			'0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+			'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
+			'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z'
+		};
 
-		return false;
+		size_t i = 0;
+
+		for (size_t count = service->message_count; count; ++i, count /= 62)
+			id[i] = BASE62[count % 62];
+
+		for (size_t j = 0, l = i - 1; j < l; ++j, --l)
+			std::swap(id[j], id[l]);
 	}
 
+	if (!aprservice_send_message_ex(service, destination, content, id, timeout, callback, param))
+		return false;
+
+	if (++service->message_count == 0x369B13E0)
+		service->message_count = 0;
+
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_set_position(struct aprservice* service, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course)
+bool                       APRSERVICE_CALL aprservice_send_message_ex(struct aprservice* service, const char* destination, const char* content, const char* id, uint32_t timeout, aprservice_message_callback callback, void* param)
 {
-	if (!aprs_packet_position_set_speed(service->position, speed))
+	if (!aprservice_is_connected(service))
+		return false;
+
+	if (aprservice_is_read_only(service))
+		return false;
+
+	aprs_packet* packet;
+
+	if (!(packet = aprs_packet_message_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), destination, content)))
 	{
-		aprservice_log_error(aprs_packet_position_set_speed, false);
+		aprservice_log_error(aprs_packet_message_init, nullptr);
 
 		return false;
 	}
 
-	if (!aprs_packet_position_set_course(service->position, course))
+	if (id && !aprs_packet_message_set_id(packet, id))
 	{
-		aprservice_log_error(aprs_packet_position_set_course, false);
+		aprservice_log_error(aprs_packet_message_set_id, false);
+
+		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
-	if (!aprs_packet_position_set_altitude(service->position, altitude))
+	if (!id || !callback || (aprs_packet_message_get_type(packet) != APRS_MESSAGE_TYPE_MESSAGE))
 	{
-		aprservice_log_error(aprs_packet_position_set_altitude, false);
+		if (!aprservice_send(service, packet))
+		{
+			aprservice_log_error(aprservice_send, false);
 
-		return false;
+			aprs_packet_deinit(packet);
+
+			return false;
+		}
+
+		aprs_packet_deinit(packet);
+
+		return true;
 	}
 
-	if (!aprs_packet_position_set_latitude(service->position, latitude))
+	std::string line;
+
+	if (!aprservice_connection_encode_packet(service->connection, packet, line))
 	{
-		aprservice_log_error(aprs_packet_position_set_latitude, false);
+		aprservice_log_error(aprservice_connection_encode_packet, false);
+
+		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
-	if (!aprs_packet_position_set_longitude(service->position, longitude))
+	aprs_packet_deinit(packet);
+
+	if (!aprservice_connection_write_encoded(service->connection, std::string(line), APRSERVICE_PRIORITY_MESSAGE, {}))
 	{
-		aprservice_log_error(aprs_packet_position_set_longitude, false);
+		aprservice_log_error(aprservice_connection_write_encoded, false);
 
 		return false;
 	}
 
+	auto context = new aprservice_message_callback_context
+	{
+		.key            = aprservice_message_callback_queue_key(destination, id),
+		.heap_index     = 0,
+		.timeout        = aprservice_get_time_ms(service) + (timeout * 1000ull),
+		.callback       = callback,
+		.callback_param = param,
+
+		.line           = std::move(line),
+		.task           = nullptr,
+		.attempts       = 1
+	};
+
+	if (service->message_retry_count && service->message_retry_interval)
+		context->task = aprservice_task_schedule_ms(service, (uint32_t)std::min<uint64_t>(service->message_retry_interval * 1000ull, UINT32_MAX), &aprservice_message_retry, context);
+
+	aprservice_message_callback_queue_push(&service->message_callbacks, context);
+
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_set_position_type(struct aprservice* service, enum APRSERVICE_POSITION_TYPES value)
+bool                       APRSERVICE_CALL aprservice_send_message_ack(struct aprservice* service, const char* destination, const char* id)
 {
-	if (value >= APRSERVICE_POSITION_TYPES_COUNT)
+	if (!aprservice_is_connected(service))
 		return false;
 
-	switch (value)
-	{
-		case APRSERVICE_POSITION_TYPE_MIC_E:
-			if (auto packet = aprs_packet_position_init_mic_e(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), aprs_packet_position_get_latitude(service->position), aprs_packet_position_get_longitude(service->position), aprs_packet_position_get_altitude(service->position), aprs_packet_position_get_speed(service->position), aprs_packet_position_get_course(service->position), aprs_packet_position_get_comment(service->position), aprs_packet_position_get_symbol_table(service->position), aprs_packet_position_get_symbol_table_key(service->position), APRS_MIC_E_MESSAGE_OFF_DUTY))
-			{
-				aprs_packet_deinit(service->position);
-
-				service->position = packet;
-
-				return true;
-			}
-			aprservice_log_error(aprs_packet_position_init_mic_e, nullptr);
-			return false;
+	if (aprservice_is_read_only(service))
+		return false;
 
-		case APRSERVICE_POSITION_TYPE_POSITION:
-			if (auto packet = aprs_packet_position_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), aprs_packet_position_get_latitude(service->position), aprs_packet_position_get_longitude(service->position), aprs_packet_position_get_altitude(service->position), aprs_packet_position_get_speed(service->position), aprs_packet_position_get_course(service->position), aprs_packet_position_get_comment(service->position), aprs_packet_position_get_symbol_table(service->position), aprs_packet_position_get_symbol_table_key(service->position), aprservice_get_time_type(service)))
-			{
-				aprs_packet_deinit(service->position);
+	aprs_packet* packet;
 
-				service->position = packet;
+	if (!(packet = aprs_packet_message_init_ack(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), destination, id)))
+	{
+		aprservice_log_error(aprs_packet_message_init_ack, nullptr);
 
-				return true;
-			}
-			aprservice_log_error(aprs_packet_position_init, nullptr);
-			return false;
+		return false;
+	}
 
-		case APRSERVICE_POSITION_TYPE_POSITION_COMPRESSED:
-			if (auto packet = aprs_packet_position_init_compressed(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), aprs_packet_position_get_latitude(service->position), aprs_packet_position_get_longitude(service->position), aprs_packet_position_get_altitude(service->position), aprs_packet_position_get_speed(service->position), aprs_packet_position_get_course(service->position), aprs_packet_position_get_comment(service->position), aprs_packet_position_get_symbol_table(service->position), aprs_packet_position_get_symbol_table_key(service->position), aprservice_get_time_type(service)))
-			{
-				aprs_packet_deinit(service->position);
+	if (!aprservice_send_ex(service, packet, APRSERVICE_PRIORITY_ACK))
+	{
+		aprservice_log_error(aprservice_send_ex, false);
 
-				service->position = packet;
+		aprs_packet_deinit(packet);
 
-				return true;
-			}
-			aprservice_log_error(aprs_packet_position_init_compressed, nullptr);
-			return false;
+		return false;
 	}
 
-	return false;
+	aprs_packet_deinit(packet);
+
+	return true;
 }
-bool                       APRSERVICE_CALL aprservice_set_event_handler(struct aprservice* service, enum APRSERVICE_EVENTS event, aprservice_event_handler handler, void* param)
+bool                       APRSERVICE_CALL aprservice_send_message_reject(struct aprservice* service, const char* destination, const char* id)
 {
-	if (event >= APRSERVICE_EVENTS_COUNT)
+	if (!aprservice_is_connected(service))
 		return false;
 
-	service->events[event] = { .handler = handler, .handler_param = param };
+	if (aprservice_is_read_only(service))
+		return false;
 
-	return true;
-}
-void                       APRSERVICE_CALL aprservice_set_default_event_handler(struct aprservice* service, aprservice_event_handler handler, void* param)
-{
-	service->events[APRSERVICE_EVENTS_COUNT] = { .handler = handler, .handler_param = param };
-}
-void                       APRSERVICE_CALL aprservice_set_command_prefix(struct aprservice* service, const char* value)
-{
-	if (!value)
-		service->command_prefix.clear();
-	else
-		service->command_prefix = value;
-}
-void                       APRSERVICE_CALL aprservice_set_connection_timeout(struct aprservice* service, uint32_t seconds)
-{
-	service->connection_timeout = seconds;
-}
-void                       APRSERVICE_CALL aprservice_enable_monitoring(struct aprservice* service, bool value)
-{
-	service->is_monitoring = value;
-}
-bool                       APRSERVICE_CALL aprservice_poll(struct aprservice* service)
-{
-	aprservice_poll_tasks(service);
-	aprservice_poll_messages(service);
+	aprs_packet* packet;
 
-	if (aprservice_is_connected(service) && !aprservice_poll_connection(service))
-		;
+	if (!(packet = aprs_packet_message_init_reject(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), destination, id)))
+	{
+		aprservice_log_error(aprs_packet_message_init_reject, nullptr);
+
+		return false;
+	}
+
+	if (!aprservice_send_ex(service, packet, APRSERVICE_PRIORITY_ACK))
+	{
+		aprservice_log_error(aprservice_send_ex, false);
+
+		aprs_packet_deinit(packet);
+
+		return false;
+	}
+
+	aprs_packet_deinit(packet);
 
 	return true;
 }
-void                                       aprservice_poll_tasks(struct aprservice* service)
+bool                       APRSERVICE_CALL aprservice_send_weather(struct aprservice* service, uint16_t wind_speed, uint16_t wind_speed_gust, uint16_t wind_direction, uint16_t rainfall_last_hour, uint16_t rainfall_last_24_hours, uint16_t rainfall_since_midnight, uint8_t humidity, int16_t temperature, uint32_t barometric_pressure, const char* type, char software)
 {
-	for (auto it = service->tasks.begin(); it != service->tasks.end(); )
-	{
-		if (it->first > aprservice_get_time(service))
-			break;
+	if (!aprservice_is_connected(service))
+		return false;
 
-		for (auto jt = it->second.begin(); jt != it->second.end(); )
-		{
-			auto                        task             = *jt;
-			aprservice_task_information task_information =
-			{
-				.is_canceled = false,
+	if (aprservice_is_read_only(service))
+		return false;
 
-				.seconds     = task->seconds,
-				.reschedule  = false
-			};
+	aprs_packet* packet;
 
-			task->handler(service, &task_information, task->handler_param);
+	if (!(packet = aprs_packet_weather_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), type, software)))
+	{
+		aprservice_log_error(aprs_packet_weather_init, nullptr);
+
+		return false;
+	}
 
-			it->second.erase(jt++);
+	if (!aprs_packet_weather_set_wind_speed(packet, wind_speed))
+	{
+		aprservice_log_error(aprs_packet_weather_set_wind_speed, false);
 
-			if (!task_information.reschedule)
-				delete task;
-			else
-				service->tasks[aprservice_get_time(service) + task_information.seconds].push_back(task);
-		}
+		aprs_packet_deinit(packet);
 
-		service->tasks.erase(it++);
+		return false;
 	}
-}
-void                                       aprservice_poll_messages(struct aprservice* service)
-{
-	service->message_callbacks.remove_if([service](aprservice_message_callback_context* context) {
-		if (context->timeout < aprservice_get_time(service))
-			return false;
-
-		context->callback(service, APRSERVICE_MESSAGE_ERROR_TIMEOUT, context->callback_param);
 
-		if (auto it = service->message_callbacks_index.find(context->station); it != service->message_callbacks_index.end())
-		{
-			for (auto jt = it->second.begin(); jt != it->second.end(); ++jt)
-			{
-				if (&*jt == context)
-				{
-					it->second.erase(jt);
+	if (!aprs_packet_weather_set_wind_speed_gust(packet, wind_speed_gust))
+	{
+		aprservice_log_error(aprs_packet_weather_set_wind_speed_gust, false);
 
-					break;
-				}
-			}
+		aprs_packet_deinit(packet);
 
-			if (it->second.empty())
-				service->message_callbacks_index.erase(it);
-		}
+		return false;
+	}
 
-		return true;
-	});
-}
-bool                                       aprservice_poll_connection(struct aprservice* service)
-{
-	static auto on_receive_packet = [](aprservice* service, aprs_packet* packet, aprservice_connection* connection)
+	if (!aprs_packet_weather_set_wind_direction(packet, wind_direction))
 	{
-		auto packet_type   = aprs_packet_get_type(packet);
-		auto packet_sender = aprs_packet_get_sender(packet);
+		aprservice_log_error(aprs_packet_weather_set_wind_direction, false);
 
-		aprservice_event_execute(service, APRSERVICE_EVENT_RECEIVE_PACKET, { .packet = packet });
+		aprs_packet_deinit(packet);
 
-		if (packet_type == APRS_PACKET_TYPE_MESSAGE)
-		{
-			auto packet_message_id          = aprs_packet_message_get_id(packet);
-			auto packet_message_type        = aprs_packet_message_get_type(packet);
-			auto packet_message_content     = aprs_packet_message_get_content(packet);
-			auto packet_message_destination = aprs_packet_message_get_destination(packet);
+		return false;
+	}
 
-			switch (packet_message_type)
-			{
-				case APRS_MESSAGE_TYPE_ACK:
-				case APRS_MESSAGE_TYPE_REJECT:
-					if (packet_message_id && !stricmp(aprservice_get_station(service), packet_message_destination))
-						if (auto it = service->message_callbacks_index.find(packet_sender); it != service->message_callbacks_index.end())
-							for (auto jt = it->second.begin(); jt != it->second.end(); ++jt)
-								if (!jt->id.compare(packet_message_id))
-								{
-									jt->callback(service, (packet_message_type == APRS_MESSAGE_TYPE_ACK) ? APRSERVICE_MESSAGE_ERROR_SUCCESS : APRSERVICE_MESSAGE_ERROR_REJECTED, jt->callback_param);
+	if (!aprs_packet_weather_set_rainfall_last_hour(packet, rainfall_last_hour))
+	{
+		aprservice_log_error(aprs_packet_weather_set_rainfall_last_hour, false);
 
-									for (auto lt = service->message_callbacks.begin(); lt != service->message_callbacks.end(); ++lt)
-										if (*lt == &*jt)
-										{
-											service->message_callbacks.erase(lt);
+		aprs_packet_deinit(packet);
 
-											break;
-										}
+		return false;
+	}
 
-									it->second.erase(jt);
+	if (!aprs_packet_weather_set_rainfall_last_24_hours(packet, rainfall_last_24_hours))
+	{
+		aprservice_log_error(aprs_packet_weather_set_rainfall_last_24_hours, false);
 
-									if (it->second.empty())
-										service->message_callbacks_index.erase(it);
+		aprs_packet_deinit(packet);
 
-									break;
-								}
-					break;
+		return false;
+	}
 
-				case APRS_MESSAGE_TYPE_MESSAGE:
-					if (stricmp(aprservice_get_station(service), packet_message_destination))
-					{
-						if (aprservice_is_monitoring_enabled(service))
-							aprservice_event_execute(service, APRSERVICE_EVENT_RECEIVE_MESSAGE, { .packet = packet, .id = packet_message_id, .sender = packet_sender, .content = packet_message_content, .destination = packet_message_destination });
-					}
-					else
-					{
-						if (packet_message_id)
-							aprservice_send_message_ack(service, packet_sender, packet_message_id);
+	if (!aprs_packet_weather_set_rainfall_since_midnight(packet, rainfall_since_midnight))
+	{
+		aprservice_log_error(aprs_packet_weather_set_rainfall_since_midnight, false);
 
-						if (std::string_view packet_message_content_view(packet_message_content); packet_message_content_view.starts_with(service->command_prefix))
-						{
-							std::string_view command_name = packet_message_content_view.substr(service->command_prefix.length());
-							std::string_view command_args;
+		aprs_packet_deinit(packet);
 
-							if (auto i = packet_message_content_view.find_first_of(' '); i != packet_message_content_view.npos)
-							{
-								command_name = command_name.substr(0, i);
+		return false;
+	}
 
-								if ((i = packet_message_content_view.find_first_not_of(' ', i)) != packet_message_content_view.npos)
-									command_args = packet_message_content_view.substr(i);
-							}
+	if (!aprs_packet_weather_set_humidity(packet, humidity))
+	{
+		aprservice_log_error(aprs_packet_weather_set_humidity, false);
 
-							if (!command_name.empty() || !aprservice_execute_command(service, packet, packet_sender, command_name.data(), command_args.data()))
-								aprservice_event_execute(service, APRSERVICE_EVENT_RECEIVE_MESSAGE, { .packet = packet, .id = packet_message_id, .sender = packet_sender, .content = packet_message_content, .destination = packet_message_destination });
-						}
-					}
-					break;
-			}
-		}
-	};
+		aprs_packet_deinit(packet);
 
-	if (!aprservice_connection_poll(service->connection))
+		return false;
+	}
+
+	if (!aprs_packet_weather_set_temperature(packet, temperature))
 	{
-		aprservice_disconnect(service);
+		aprservice_log_error(aprs_packet_weather_set_temperature, false);
+
+		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
-	switch (service->connection->type)
+	if (!aprs_packet_weather_set_barometric_pressure(packet, barometric_pressure))
 	{
-		case APRSERVICE_CONNECTION_TYPE_APRS_IS:
-			while (aprservice_connection_read_string(service->connection, service->line))
-				if (service->line.starts_with("# "))
-				{
-					if ((service->connection->auth.state == APRSERVICE_AUTH_STATE_SENT) && aprservice_connection_auth_from_string(&service->connection->auth, &service->line[2], service->connection->passcode != 0))
-						aprservice_event_execute(service, APRSERVICE_EVENT_AUTHENTICATE, { .message = service->connection->auth.message.c_str(), .success = service->connection->auth.success, .verified = service->connection->auth.verified });
-					else
-						aprservice_event_execute(service, APRSERVICE_EVENT_RECEIVE_SERVER_MESSAGE, { .content = &service->line[2] });
-				}
-				else if (auto packet = aprs_packet_init_from_string(service->line.c_str()))
-				{
-					on_receive_packet(service, packet, service->connection);
-
-					aprs_packet_deinit(packet);
-				}
-			break;
+		aprservice_log_error(aprs_packet_weather_set_barometric_pressure, false);
 
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP:
-		case APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL:
-			while (aprservice_connection_read_string(service->connection, service->line))
-				if (auto packet = aprs_packet_init_from_string(service->line.c_str()))
-				{
-					on_receive_packet(service, packet, service->connection);
+		aprs_packet_deinit(packet);
 
-					aprs_packet_deinit(packet);
-				}
-			break;
+		return false;
 	}
 
-	if (!aprservice_connection_is_open(service->connection))
+	if (!aprservice_send(service, packet))
 	{
-		aprservice_disconnect(service);
+		aprservice_log_error(aprservice_send, false);
+
+		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
+	aprs_packet_deinit(packet);
+
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send(struct aprservice* service, struct aprs_packet* packet)
+bool                       APRSERVICE_CALL aprservice_send_position(struct aprservice* service)
 {
-	if (!aprservice_connection_write_packet(service->connection, packet))
+	if (!aprservice_is_connected(service))
+		return false;
+
+	if (aprservice_is_read_only(service))
+		return false;
+
+	if (!aprservice_send(service, service->position))
 	{
-		aprservice_log_error(aprservice_connection_write_packet, false);
+		aprservice_log_error(aprservice_send, false);
 
 		return false;
 	}
 
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send_raw(struct aprservice* service, const char* content)
+bool                       APRSERVICE_CALL aprservice_send_position_ex(struct aprservice* service, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course, const char* comment)
 {
 	if (!aprservice_is_connected(service))
 		return false;
@@ -2125,13 +4016,16 @@ bool                       APRSERVICE_CALL aprservice_send_raw(struct aprservice
 
 	aprs_packet* packet;
 
-	if (!(packet = aprs_packet_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service))))
+	if (!(packet = aprs_packet_position_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), latitude, longitude, altitude, speed, course, comment, aprservice_get_symbol_table(service), aprservice_get_symbol_table_key(service), aprservice_get_time_type(service))))
 	{
-		aprservice_log_error(aprs_packet_init, nullptr);
+		aprservice_log_error(aprs_packet_position_init, nullptr);
 
 		return false;
 	}
 
+	aprs_packet_position_enable_messaging(packet, true);
+	aprs_packet_position_enable_compression(packet, aprs_packet_position_is_compressed(service->position));
+
 	if (!aprservice_send(service, packet))
 	{
 		aprservice_log_error(aprservice_send, false);
@@ -2145,7 +4039,14 @@ bool                       APRSERVICE_CALL aprservice_send_raw(struct aprservice
 
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send_item(struct aprservice* service, const char* name, const char* comment, char symbol_table, char symbol_table_key, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course, bool live)
+bool                       APRSERVICE_CALL aprservice_send_telemetry(struct aprservice* service, uint8_t a1, uint8_t a2, uint8_t a3, uint8_t a4, uint8_t a5, uint8_t digital)
+{
+	if (service->telemetry_count++ == 999)
+		service->telemetry_count = 0;
+
+	return aprservice_send_telemetry_ex(service, a1, a2, a3, a4, a5, digital, aprservice_get_comment(service), service->telemetry_count);
+}
+bool                       APRSERVICE_CALL aprservice_send_telemetry_ex(struct aprservice* service, uint8_t a1, uint8_t a2, uint8_t a3, uint8_t a4, uint8_t a5, uint8_t digital, const char* comment, uint16_t sequence)
 {
 	if (!aprservice_is_connected(service))
 		return false;
@@ -2155,79 +4056,131 @@ bool                       APRSERVICE_CALL aprservice_send_item(struct aprservic
 
 	aprs_packet* packet;
 
-	if (!(packet = aprs_packet_item_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), name, symbol_table, symbol_table_key)))
+	if (!(packet = aprs_packet_telemetry_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), a1, a2, a3, a4, a5, digital, sequence)))
 	{
-		aprservice_log_error(aprs_packet_item_init, nullptr);
+		aprservice_log_error(aprs_packet_telemetry_init, nullptr);
 
 		return false;
 	}
 
-	if (!aprs_packet_item_set_alive(packet, live))
+	if (comment && !aprs_packet_telemetry_set_comment(packet, comment))
 	{
-		aprservice_log_error(aprs_packet_item_set_alive, false);
+		aprservice_log_error(aprs_packet_telemetry_set_comment, false);
 
 		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
-	if (!aprs_packet_item_set_speed(packet, speed))
+	if (!aprservice_send(service, packet))
 	{
-		aprservice_log_error(aprs_packet_item_set_speed, false);
+		aprservice_log_error(aprservice_send, false);
 
 		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
-	if (!aprs_packet_item_set_course(packet, course))
-	{
-		aprservice_log_error(aprs_packet_item_set_course, false);
+	aprs_packet_deinit(packet);
 
-		aprs_packet_deinit(packet);
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_send_telemetry_float(struct aprservice* service, float a1, float a2, float a3, float a4, float a5, uint8_t digital)
+{
+	if (service->telemetry_count++ == 999)
+		service->telemetry_count = 0;
+
+	return aprservice_send_telemetry_float_ex(service, a1, a2, a3, a4, a5, digital, aprservice_get_comment(service), service->telemetry_count);
+}
+bool                       APRSERVICE_CALL aprservice_send_telemetry_float_ex(struct aprservice* service, float a1, float a2, float a3, float a4, float a5, uint8_t digital, const char* comment, uint16_t sequence)
+{
+	if (!aprservice_is_connected(service))
+		return false;
+
+	if (aprservice_is_read_only(service))
+		return false;
+
+	aprs_packet* packet;
+
+	if (!(packet = aprs_packet_telemetry_init_float(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), a1, a2, a3, a4, a5, digital, sequence)))
+	{
+		aprservice_log_error(aprs_packet_telemetry_init_float, nullptr);
 
 		return false;
 	}
 
-	if (!aprs_packet_item_set_comment(packet, comment))
+	if (comment && !aprs_packet_telemetry_set_comment(packet, comment))
 	{
-		aprservice_log_error(aprs_packet_item_set_comment, false);
+		aprservice_log_error(aprs_packet_telemetry_set_comment, false);
 
 		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
-	if (!aprs_packet_item_set_altitude(packet, altitude))
+	if (!aprservice_send(service, packet))
 	{
-		aprservice_log_error(aprs_packet_item_set_altitude, false);
+		aprservice_log_error(aprservice_send, false);
 
 		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
-	if (!aprs_packet_item_set_latitude(packet, latitude))
-	{
-		aprservice_log_error(aprs_packet_item_set_latitude, false);
+	aprs_packet_deinit(packet);
 
-		aprs_packet_deinit(packet);
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_send_user_defined(struct aprservice* service, char id, char type, const char* data)
+{
+	if (!aprservice_is_connected(service))
+		return false;
+
+	if (aprservice_is_read_only(service))
+		return false;
+
+	aprs_packet* packet;
+
+	if (!(packet = aprs_packet_user_defined_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), id, type, data)))
+	{
+		aprservice_log_error(aprs_packet_user_defined_init, nullptr);
 
 		return false;
 	}
 
-	if (!aprs_packet_item_set_longitude(packet, longitude))
+	if (!aprservice_send(service, packet))
 	{
-		aprservice_log_error(aprs_packet_item_set_longitude, false);
+		aprservice_log_error(aprservice_send, false);
 
 		aprs_packet_deinit(packet);
 
 		return false;
 	}
 
-	if (!aprs_packet_item_set_compressed(packet, aprservice_is_compression_enabled(service)))
+	aprs_packet_deinit(packet);
+
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_send_third_party(struct aprservice* service, const char* content)
+{
+	if (!aprservice_is_connected(service))
+		return false;
+
+	if (aprservice_is_read_only(service))
+		return false;
+
+	aprs_packet* packet;
+
+	if (!(packet = aprs_packet_third_party_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service))))
 	{
-		aprservice_log_error(aprs_packet_item_set_compressed, false);
+		aprservice_log_error(aprs_packet_third_party_init, nullptr);
+
+		return false;
+	}
+
+	if (!aprs_packet_third_party_set_content(packet, content))
+	{
+		aprservice_log_error(aprs_packet_third_party_set_content, false);
 
 		aprs_packet_deinit(packet);
 
@@ -2247,784 +4200,1315 @@ bool                       APRSERVICE_CALL aprservice_send_item(struct aprservic
 
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send_object(struct aprservice* service, const char* name, const char* comment, char symbol_table, char symbol_table_key, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course, bool live)
+bool                       APRSERVICE_CALL aprservice_connect_aprs_is(struct aprservice* service, const char* hostname, uint16_t port, uint16_t passcode)
 {
-	if (!aprservice_is_connected(service))
-		return false;
-
-	if (aprservice_is_read_only(service))
+	if (aprservice_is_connected(service))
 		return false;
 
-	aprs_packet* packet;
-
-	if (!(packet = aprs_packet_object_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), name, symbol_table, symbol_table_key, aprservice_get_time_type(service))))
+	if (!(service->connection = aprservice_connection_init(service, APRSERVICE_CONNECTION_TYPE_APRS_IS, hostname, port, 0, passcode)))
 	{
-		aprservice_log_error(aprs_packet_object_init, nullptr);
+		// aprservice_log_error(aprservice_connection_init, nullptr);
 
 		return false;
 	}
 
-	if (!aprs_packet_object_set_alive(packet, live))
+	if (!aprservice_connection_open(service->connection))
 	{
-		aprservice_log_error(aprs_packet_object_set_alive, false);
+		// aprservice_log_error(aprservice_connection_open, false);
 
-		aprs_packet_deinit(packet);
+		aprservice_connection_deinit(service->connection);
+
+		service->connection = nullptr;
 
 		return false;
 	}
 
-	if (!aprs_packet_object_set_speed(packet, speed))
-	{
-		aprservice_log_error(aprs_packet_object_set_speed, false);
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_connect_kiss_tnc_tcp(struct aprservice* service, const char* hostname, uint16_t port)
+{
+	if (aprservice_is_connected(service))
+		return false;
 
-		aprs_packet_deinit(packet);
+	if (!(service->connection = aprservice_connection_init(service, APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP, hostname, port, 0, 0)))
+	{
+		// aprservice_log_error(aprservice_connection_init, nullptr);
 
 		return false;
 	}
 
-	if (!aprs_packet_object_set_course(packet, course))
+	if (!aprservice_connection_open(service->connection))
 	{
-		aprservice_log_error(aprs_packet_object_set_course, false);
+		// aprservice_log_error(aprservice_connection_open, false);
 
-		aprs_packet_deinit(packet);
+		aprservice_connection_deinit(service->connection);
+
+		service->connection = nullptr;
 
 		return false;
 	}
 
-	if (!aprs_packet_object_set_comment(packet, comment))
-	{
-		aprservice_log_error(aprs_packet_object_set_comment, false);
+	return true;
+}
+bool                       APRSERVICE_CALL aprservice_connect_kiss_tnc_serial(struct aprservice* service, const char* device, uint32_t speed)
+{
+	if (aprservice_is_connected(service))
+		return false;
 
-		aprs_packet_deinit(packet);
+	if (!(service->connection = aprservice_connection_init(service, APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL, device, 0, speed, 0)))
+	{
+		// aprservice_log_error(aprservice_connection_init, nullptr);
 
 		return false;
 	}
 
-	if (!aprs_packet_object_set_altitude(packet, altitude))
+	if (!aprservice_connection_open(service->connection))
 	{
-		aprservice_log_error(aprs_packet_object_set_altitude, false);
+		// aprservice_log_error(aprservice_connection_open, false);
 
-		aprs_packet_deinit(packet);
+		aprservice_connection_deinit(service->connection);
+
+		service->connection = nullptr;
 
 		return false;
 	}
 
-	if (!aprs_packet_object_set_latitude(packet, latitude))
+	return true;
+}
+void                       APRSERVICE_CALL aprservice_disconnect(struct aprservice* service)
+{
+	if (aprservice_is_connected(service))
 	{
-		aprservice_log_error(aprs_packet_object_set_latitude, false);
+		aprservice_connection_deinit(service->connection);
+		service->connection = nullptr;
 
-		aprs_packet_deinit(packet);
+		auto message_callbacks = std::move(service->message_callbacks.heap);
 
-		return false;
+		service->message_callbacks.heap.clear();
+		service->message_callbacks.index.clear();
+
+		for (auto context : message_callbacks)
+			aprservice_message_complete(service, context, APRSERVICE_MESSAGE_ERROR_DISCONNECTED);
+
+		aprservice_loop_wake(service);
 	}
+}
 
-	if (!aprs_packet_object_set_longitude(packet, longitude))
+int                        APRSERVICE_CALL aprservice_wait_for_io(struct aprservice* service, uint32_t timeout)
+{
+	return aprservice_wait_for_io_ms(service, timeout * 1000);
+}
+int                        APRSERVICE_CALL aprservice_wait_for_io_ms(struct aprservice* service, uint32_t timeout)
+{
+	if (!aprservice_is_connected(service))
+		return 0;
+
+	switch (aprservice_connection_wait_for_io(service->connection, timeout))
 	{
-		aprservice_log_error(aprs_packet_object_set_longitude, false);
+		case 0:
+			aprservice_disconnect(service);
+			return 0;
 
-		aprs_packet_deinit(packet);
+		case -1:
+			return -1;
 
-		return false;
+		case -2:
+			aprservice_disconnect(service);
+			return -2;
 	}
 
-	if (!aprs_packet_object_set_compressed(packet, aprservice_is_compression_enabled(service)))
+	return 1;
+}
+
+uint64_t                                   aprservice_loop_get_time_ms()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#if defined(APRSERVICE_LOOP_IO_URING)
+void                                       aprservice_loop_ready(aprservice_loop_entry* entry, bool is_readable, bool is_writable);
+
+// submits everything prepared and waits up to timeout milliseconds for a completion
+// @return false on error
+bool                                       aprservice_loop_io_uring_enter(aprservice_loop_io_uring* io_uring, uint32_t timeout)
+{
+	__kernel_timespec      wait_time = { .tv_sec = timeout / 1000, .tv_nsec = (timeout % 1000) * 1000000ll };
+	io_uring_getevents_arg wait_arg  = { .sigmask = 0, .sigmask_sz = 0, .pad = 0, .ts = (uint64_t)&wait_time };
+
+	auto result = syscall(__NR_io_uring_enter, io_uring->fd, io_uring->sq_pending, timeout ? 1 : 0, timeout ? (IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG) : IORING_ENTER_EXT_ARG, &wait_arg, sizeof(wait_arg));
+
+	if (result == -1)
 	{
-		aprservice_log_error(aprs_packet_object_set_compressed, false);
+		auto error = errno;
 
-		aprs_packet_deinit(packet);
+		switch (error)
+		{
+			case EINTR:
+			case ETIME:
+				return true;
+		}
+
+		aprservice_log_error(io_uring_enter, error);
 
 		return false;
 	}
 
-	if (!aprservice_send(service, packet))
-	{
-		aprservice_log_error(aprservice_send, false);
+	io_uring->sq_pending -= (unsigned)result;
 
-		aprs_packet_deinit(packet);
+	return true;
+}
+// @return nullptr if the submission queue is full
+io_uring_sqe*                              aprservice_loop_io_uring_get_sqe(aprservice_loop_io_uring* io_uring)
+{
+	auto tail = *io_uring->sq_tail;
+
+	if ((tail - __atomic_load_n(io_uring->sq_head, __ATOMIC_ACQUIRE)) >= io_uring->sq_entries)
+		if (!aprservice_loop_io_uring_enter(io_uring, 0) || ((tail - __atomic_load_n(io_uring->sq_head, __ATOMIC_ACQUIRE)) >= io_uring->sq_entries))
+		{
+			aprservice_log_error(aprservice_loop_io_uring_get_sqe, nullptr);
+
+			return nullptr;
+		}
+
+	auto sqe = &io_uring->sqes[tail & *io_uring->sq_mask];
 
+	memset(sqe, 0, sizeof(io_uring_sqe));
+
+	// without sqpoll the kernel only reads submissions during io_uring_enter
+	__atomic_store_n(io_uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	++io_uring->sq_pending;
+
+	return sqe;
+}
+// hands buffer id back to the kernel for the next receive
+void                                       aprservice_loop_io_uring_add_buffer(aprservice_loop_io_uring* io_uring, uint16_t id)
+{
+	// bufs starts after an empty struct when the kernel header is compiled as c++, the ring itself starts at the first buffer
+	auto buffer = &reinterpret_cast<io_uring_buf*>(io_uring->buffers_ring)[io_uring->buffers_tail & (APRSERVICE_LOOP_IO_URING_BUFFER_COUNT - 1)];
+
+	buffer->addr = (uint64_t)&io_uring->buffers[id * APRSERVICE_LOOP_IO_URING_BUFFER_SIZE];
+	buffer->len  = APRSERVICE_LOOP_IO_URING_BUFFER_SIZE;
+	buffer->bid  = id;
+
+	__atomic_store_n(&io_uring->buffers_ring->tail, ++io_uring->buffers_tail, __ATOMIC_RELEASE);
+}
+// @return false on error
+bool                                       aprservice_loop_io_uring_submit_read(aprservice_loop_io_uring_watch* watch)
+{
+	auto sqe = aprservice_loop_io_uring_get_sqe(watch->io_uring);
+
+	if (!sqe)
 		return false;
+
+	sqe->fd        = watch->fd;
+	sqe->user_data = (uint64_t)watch | APRSERVICE_LOOP_IO_URING_OP_READ;
+
+	if (watch->is_socket)
+	{
+		sqe->opcode    = IORING_OP_RECV;
+		sqe->ioprio    = IORING_RECV_MULTISHOT;
+		sqe->flags     = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = 0;
+	}
+	else
+	{
+		// serial devices are only polled, aprservice_connection_read still reads them
+		sqe->opcode        = IORING_OP_POLL_ADD;
+		sqe->len           = IORING_POLL_ADD_MULTI;
+		sqe->poll32_events = POLLIN;
 	}
 
-	aprs_packet_deinit(packet);
+	watch->is_reading = true;
 
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send_status(struct aprservice* service, const char* message)
+// @return false on error
+bool                                       aprservice_loop_io_uring_submit_write(aprservice_loop_io_uring_watch* watch)
 {
-	if (!aprservice_is_connected(service))
+	auto sqe = aprservice_loop_io_uring_get_sqe(watch->io_uring);
+
+	if (!sqe)
 		return false;
 
-	if (aprservice_is_read_only(service))
+	sqe->opcode        = IORING_OP_POLL_ADD;
+	sqe->fd            = watch->fd;
+	sqe->user_data     = (uint64_t)watch | APRSERVICE_LOOP_IO_URING_OP_WRITE;
+	sqe->poll32_events = POLLOUT;
+
+	watch->is_writing = true;
+
+	return true;
+}
+// @return false on error
+bool                                       aprservice_loop_io_uring_submit_cancel(aprservice_loop_io_uring_watch* watch, APRSERVICE_LOOP_IO_URING_OPS op)
+{
+	auto sqe = aprservice_loop_io_uring_get_sqe(watch->io_uring);
+
+	if (!sqe)
 		return false;
 
-	aprs_packet* packet;
+	sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+	sqe->addr      = (uint64_t)watch | op;
+	sqe->user_data = APRSERVICE_LOOP_IO_URING_OP_CANCEL;
 
-	if (!(packet = aprs_packet_status_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), message)))
+	return true;
+}
+// handles every completion the kernel has posted
+void                                       aprservice_loop_io_uring_complete(aprservice_loop_io_uring* io_uring)
+{
+	auto head = *io_uring->cq_head;
+	auto tail = __atomic_load_n(io_uring->cq_tail, __ATOMIC_ACQUIRE);
+
+	for (; head != tail; ++head)
 	{
-		aprservice_log_error(aprs_packet_status_init, nullptr);
+		auto cqe   = &io_uring->cqes[head & *io_uring->cq_mask];
+		auto op    = cqe->user_data & APRSERVICE_LOOP_IO_URING_OP_MASK;
+		auto watch = (aprservice_loop_io_uring_watch*)(cqe->user_data & ~(uint64_t)APRSERVICE_LOOP_IO_URING_OP_MASK);
 
-		return false;
+		if (cqe->flags & IORING_CQE_F_BUFFER)
+		{
+			auto id = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+
+			if (watch && watch->entry && (cqe->res > 0))
+				watch->rx.push_back({ .id = id, .offset = 0, .size = (uint32_t)cqe->res });
+			else
+				aprservice_loop_io_uring_add_buffer(io_uring, id);
+		}
+
+		if (!watch || (op == APRSERVICE_LOOP_IO_URING_OP_CANCEL))
+			continue;
+
+		switch (op)
+		{
+			case APRSERVICE_LOOP_IO_URING_OP_READ:
+				if (!(cqe->flags & IORING_CQE_F_MORE))
+					watch->is_reading = false;
+
+				if (auto entry = watch->entry)
+				{
+					if (watch->is_socket && !cqe->res)
+						watch->is_closed = true;
+					else if ((cqe->res < 0) && (cqe->res != -ENOBUFS))
+					{
+						aprservice_log_error(io_uring_enter, -cqe->res);
+
+						watch->is_closed = true;
+					}
+
+					// multishot requests end when every buffer is in use and may be ended by the kernel at any time
+					// sockets are submitted again by aprservice_loop_io_uring_read once their buffers are handed back
+					if (!watch->is_socket && !watch->is_reading && !watch->is_closed && !aprservice_loop_io_uring_submit_read(watch))
+						watch->is_closed = true;
+
+					aprservice_loop_ready(entry, true, false);
+				}
+				break;
+
+			case APRSERVICE_LOOP_IO_URING_OP_WRITE:
+				watch->is_writing = false;
+
+				if (auto entry = watch->entry)
+				{
+					// aprservice_loop_update submits another poll if output would still block
+					entry->fd_write = false;
+
+					aprservice_loop_ready(entry, false, true);
+				}
+				break;
+		}
+
+		if (!watch->entry && !watch->is_reading && !watch->is_writing)
+			io_uring->watches.erase(watch->it);
 	}
 
-	aprs_time time;
+	__atomic_store_n(io_uring->cq_head, head, __ATOMIC_RELEASE);
+}
+// multishot recv needs linux 6.0 while provided buffer rings only need 5.19
+// @return false if not supported
+bool                                       aprservice_loop_io_uring_probe(aprservice_loop_io_uring* io_uring)
+{
+	int  fds[2];
+	bool is_supported = false;
 
-	if (!aprs_time_now(&time, aprservice_get_time_type(service)))
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
 	{
-		aprservice_log_error(aprs_time_now, false);
+		auto error = errno;
 
-		aprs_packet_deinit(packet);
+		aprservice_log_error(socketpair, error);
 
 		return false;
 	}
 
-	if (!aprs_packet_status_set_time(packet, &time))
+	if (auto sqe = aprservice_loop_io_uring_get_sqe(io_uring))
 	{
-		aprservice_log_error(aprs_packet_status_set_time, false);
+		sqe->opcode    = IORING_OP_RECV;
+		sqe->fd        = fds[0];
+		sqe->ioprio    = IORING_RECV_MULTISHOT;
+		sqe->flags     = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = 0;
+		// completions without a watch are ignored by aprservice_loop_io_uring_complete
+		sqe->user_data = APRSERVICE_LOOP_IO_URING_OP_READ;
 
-		aprs_packet_deinit(packet);
+		if ((send(fds[1], "", 1, 0) == 1) && aprservice_loop_io_uring_enter(io_uring, 1000))
+			for (auto head = *io_uring->cq_head; head != __atomic_load_n(io_uring->cq_tail, __ATOMIC_ACQUIRE); ++head)
+				if (auto cqe = &io_uring->cqes[head & *io_uring->cq_mask]; (cqe->user_data == APRSERVICE_LOOP_IO_URING_OP_READ) && (cqe->res == 1))
+					is_supported = true;
 
-		return false;
+		if (auto sqe = aprservice_loop_io_uring_get_sqe(io_uring))
+		{
+			sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+			sqe->addr      = APRSERVICE_LOOP_IO_URING_OP_READ;
+			sqe->user_data = APRSERVICE_LOOP_IO_URING_OP_CANCEL;
+		}
+
+		aprservice_loop_io_uring_enter(io_uring, 0);
+		aprservice_loop_io_uring_complete(io_uring);
 	}
 
-	if (!aprservice_send(service, packet))
+	close(fds[0]);
+	close(fds[1]);
+
+	if (!is_supported)
+		aprservice_log_error(IORING_RECV_MULTISHOT, "not supported");
+
+	return is_supported;
+}
+void                                       aprservice_loop_io_uring_deinit(aprservice_loop_io_uring* io_uring)
+{
+	// the kernel may still write to buffers until every request has completed
+	for (auto& watch : io_uring->watches)
 	{
-		aprservice_log_error(aprservice_send, false);
+		watch.entry = nullptr;
 
-		aprs_packet_deinit(packet);
+		if (watch.is_reading)
+			aprservice_loop_io_uring_submit_cancel(&watch, APRSERVICE_LOOP_IO_URING_OP_READ);
 
-		return false;
+		if (watch.is_writing)
+			aprservice_loop_io_uring_submit_cancel(&watch, APRSERVICE_LOOP_IO_URING_OP_WRITE);
 	}
 
-	aprs_packet_deinit(packet);
+	for (size_t i = 0; !io_uring->watches.empty() && (i < 10) && aprservice_loop_io_uring_enter(io_uring, 100); ++i)
+		aprservice_loop_io_uring_complete(io_uring);
 
-	return true;
+	if (io_uring->fd != -1)
+		close(io_uring->fd);
+
+	if (io_uring->buffers_ring)
+		munmap(io_uring->buffers_ring, APRSERVICE_LOOP_IO_URING_BUFFER_COUNT * sizeof(io_uring_buf));
+
+	if (io_uring->sqes)
+		munmap(io_uring->sqes, io_uring->sqes_size);
+
+	if (io_uring->ring)
+		munmap(io_uring->ring, io_uring->ring_size);
+
+	delete io_uring;
 }
-bool                       APRSERVICE_CALL aprservice_send_message(struct aprservice* service, const char* destination, const char* content, uint32_t timeout, aprservice_message_callback callback, void* param)
+// @return nullptr if io_uring or a feature it needs is not supported
+aprservice_loop_io_uring*                  aprservice_loop_io_uring_init()
 {
-	char id[6] = {};
+	static_assert((APRSERVICE_LOOP_IO_URING_BUFFER_COUNT & (APRSERVICE_LOOP_IO_URING_BUFFER_COUNT - 1)) == 0);
+	static_assert(alignof(aprservice_loop_io_uring_watch) > APRSERVICE_LOOP_IO_URING_OP_MASK);
 
-	if (service->message_count == 0)
-		id[0] = '0';
-	else
+	io_uring_params params = { .cq_entries = APRSERVICE_LOOP_IO_URING_CQ_SIZE, .flags = IORING_SETUP_CQSIZE };
+
+	auto io_uring = new aprservice_loop_io_uring
 	{
-		static constexpr char BASE62[] =
-		{
-			'0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
-			'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
-			'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z'
-		};
+		.fd           = (int)syscall(__NR_io_uring_setup, APRSERVICE_LOOP_IO_URING_SQ_SIZE, &params),
 
-		size_t i = 0;
+		.ring         = nullptr,
+		.ring_size    = std::max(params.sq_off.array + (params.sq_entries * sizeof(unsigned)), params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe))),
 
-		for (size_t count = service->message_count; count; ++i, count /= 62)
-			id[i] = BASE62[count % 62];
+		.sqes         = nullptr,
+		.sqes_size    = params.sq_entries * sizeof(io_uring_sqe),
+		.sq_entries   = params.sq_entries,
+		.sq_pending   = 0,
 
-		for (size_t j = 0, l = i - 1; j < l; ++j, --l)
-			std::swap(id[j], id[l]);
-	}
+		.buffers_ring = nullptr,
+		.buffers_tail = 0
+	};
 
-	if (!aprservice_send_message_ex(service, destination, content, id, timeout, callback, param))
-		return false;
+	if (io_uring->fd == -1)
+	{
+		auto error = errno;
 
-	if (++service->message_count == 0x369B13E0)
-		service->message_count = 0;
+		aprservice_log_error(io_uring_setup, error);
 
-	return true;
-}
-bool                       APRSERVICE_CALL aprservice_send_message_ex(struct aprservice* service, const char* destination, const char* content, const char* id, uint32_t timeout, aprservice_message_callback callback, void* param)
-{
-	if (!aprservice_is_connected(service))
-		return false;
+		aprservice_loop_io_uring_deinit(io_uring);
 
-	if (aprservice_is_read_only(service))
-		return false;
+		return nullptr;
+	}
+
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG))
+	{
+		aprservice_log_error(io_uring_setup, "not supported");
+
+		aprservice_loop_io_uring_deinit(io_uring);
+
+		return nullptr;
+	}
 
-	aprs_packet* packet;
+	void* ring;
+	void* sqes;
+	void* buffers_ring;
 
-	if (!(packet = aprs_packet_message_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), destination, content)))
+	if ((ring = mmap(nullptr, io_uring->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io_uring->fd, IORING_OFF_SQ_RING)) == MAP_FAILED)
 	{
-		aprservice_log_error(aprs_packet_message_init, nullptr);
+		auto error = errno;
 
-		return false;
+		aprservice_log_error(mmap, error);
+
+		aprservice_loop_io_uring_deinit(io_uring);
+
+		return nullptr;
 	}
 
-	if (id && !aprs_packet_message_set_id(packet, id))
+	io_uring->ring = ring;
+
+	if ((sqes = mmap(nullptr, io_uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io_uring->fd, IORING_OFF_SQES)) == MAP_FAILED)
 	{
-		aprservice_log_error(aprs_packet_message_set_id, false);
+		auto error = errno;
 
-		aprs_packet_deinit(packet);
+		aprservice_log_error(mmap, error);
 
-		return false;
+		aprservice_loop_io_uring_deinit(io_uring);
+
+		return nullptr;
 	}
 
-	if (!aprservice_send(service, packet))
+	io_uring->sqes    = (io_uring_sqe*)sqes;
+	io_uring->sq_head = (unsigned*)((uint8_t*)ring + params.sq_off.head);
+	io_uring->sq_tail = (unsigned*)((uint8_t*)ring + params.sq_off.tail);
+	io_uring->sq_mask = (unsigned*)((uint8_t*)ring + params.sq_off.ring_mask);
+	io_uring->cqes    = (io_uring_cqe*)((uint8_t*)ring + params.cq_off.cqes);
+	io_uring->cq_head = (unsigned*)((uint8_t*)ring + params.cq_off.head);
+	io_uring->cq_tail = (unsigned*)((uint8_t*)ring + params.cq_off.tail);
+	io_uring->cq_mask = (unsigned*)((uint8_t*)ring + params.cq_off.ring_mask);
+
+	// every submission queue entry is only ever referenced from its own slot
+	for (unsigned i = 0, *sq_array = (unsigned*)((uint8_t*)ring + params.sq_off.array); i < params.sq_entries; ++i)
+		sq_array[i] = i;
+
+	if ((buffers_ring = mmap(nullptr, APRSERVICE_LOOP_IO_URING_BUFFER_COUNT * sizeof(io_uring_buf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
 	{
-		aprservice_log_error(aprservice_send, false);
+		auto error = errno;
 
-		aprs_packet_deinit(packet);
+		aprservice_log_error(mmap, error);
 
-		return false;
+		aprservice_loop_io_uring_deinit(io_uring);
+
+		return nullptr;
 	}
 
-	if (id && callback && (aprs_packet_message_get_type(packet) == APRS_MESSAGE_TYPE_MESSAGE))
-		service->message_callbacks.push_back(&service->message_callbacks_index[destination].emplace_back(aprservice_message_callback_context {
-			.id             = id,
-			.station        = destination,
-			.timeout        = aprservice_get_time(service) + timeout,
-			.callback       = callback,
-			.callback_param = param
-		}));
+	io_uring->buffers_ring = (io_uring_buf_ring*)buffers_ring;
+	io_uring->buffers.resize(APRSERVICE_LOOP_IO_URING_BUFFER_COUNT * APRSERVICE_LOOP_IO_URING_BUFFER_SIZE);
 
-	aprs_packet_deinit(packet);
+	io_uring_buf_reg buffers_reg = { .ring_addr = (uint64_t)buffers_ring, .ring_entries = APRSERVICE_LOOP_IO_URING_BUFFER_COUNT, .bgid = 0 };
 
-	return true;
-}
-bool                       APRSERVICE_CALL aprservice_send_message_ack(struct aprservice* service, const char* destination, const char* id)
-{
-	if (!aprservice_is_connected(service))
-		return false;
+	if (syscall(__NR_io_uring_register, io_uring->fd, IORING_REGISTER_PBUF_RING, &buffers_reg, 1) == -1)
+	{
+		auto error = errno;
 
-	if (aprservice_is_read_only(service))
-		return false;
+		aprservice_log_error(io_uring_register, error);
 
-	aprs_packet* packet;
+		aprservice_loop_io_uring_deinit(io_uring);
 
-	if (!(packet = aprs_packet_message_init_ack(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), destination, id)))
+		return nullptr;
+	}
+
+	for (uint16_t id = 0; id < APRSERVICE_LOOP_IO_URING_BUFFER_COUNT; ++id)
+		aprservice_loop_io_uring_add_buffer(io_uring, id);
+
+	if (!aprservice_loop_io_uring_probe(io_uring))
 	{
-		aprservice_log_error(aprs_packet_message_init_ack, nullptr);
+		aprservice_loop_io_uring_deinit(io_uring);
 
-		return false;
+		return nullptr;
 	}
 
-	if (!aprservice_send(service, packet))
+	return io_uring;
+}
+// @return false on error
+bool                                       aprservice_loop_io_uring_add(aprservice_loop_entry* entry, int fd, bool write, bool is_socket)
+{
+	auto io_uring = entry->loop->io_uring;
+	auto watch    = entry->io_uring_watch;
+
+	if (!watch)
 	{
-		aprservice_log_error(aprservice_send, false);
+		watch = &io_uring->watches.emplace_back(aprservice_loop_io_uring_watch
+		{
+			.io_uring   = io_uring,
+			.entry      = entry,
+
+			.fd         = fd,
+			.is_socket  = is_socket,
+			.is_reading = false,
+			.is_writing = false,
+			.is_closed  = false
+		});
 
-		aprs_packet_deinit(packet);
+		watch->it             = std::prev(io_uring->watches.end());
+		entry->io_uring_watch = watch;
 
-		return false;
+		if (!aprservice_loop_io_uring_submit_read(watch))
+			return false;
 	}
 
-	aprs_packet_deinit(packet);
+	if (write && !watch->is_writing && !aprservice_loop_io_uring_submit_write(watch))
+		return false;
 
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send_message_reject(struct aprservice* service, const char* destination, const char* id)
+void                                       aprservice_loop_io_uring_remove(aprservice_loop_entry* entry)
 {
-	if (!aprservice_is_connected(service))
-		return false;
+	if (auto watch = entry->io_uring_watch)
+	{
+		auto io_uring = watch->io_uring;
 
-	if (aprservice_is_read_only(service))
-		return false;
+		entry->io_uring_watch = nullptr;
+		watch->entry          = nullptr;
 
-	aprs_packet* packet;
+		for (auto& rx : watch->rx)
+			aprservice_loop_io_uring_add_buffer(io_uring, rx.id);
 
-	if (!(packet = aprs_packet_message_init_reject(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), destination, id)))
-	{
-		aprservice_log_error(aprs_packet_message_init_reject, nullptr);
+		watch->rx.clear();
 
-		return false;
-	}
+		if (watch->is_reading)
+			aprservice_loop_io_uring_submit_cancel(watch, APRSERVICE_LOOP_IO_URING_OP_READ);
 
-	if (!aprservice_send(service, packet))
-	{
-		aprservice_log_error(aprservice_send, false);
+		if (watch->is_writing)
+			aprservice_loop_io_uring_submit_cancel(watch, APRSERVICE_LOOP_IO_URING_OP_WRITE);
 
-		aprs_packet_deinit(packet);
+		// the fd is closed next and requests still in flight would keep it open
+		aprservice_loop_io_uring_enter(io_uring, 0);
 
-		return false;
+		if (!watch->is_reading && !watch->is_writing)
+			io_uring->watches.erase(watch->it);
 	}
+}
+// @return false on error
+bool                                       aprservice_loop_io_uring_wait(aprservice_loop_io_uring* io_uring, uint32_t timeout)
+{
+	if (!aprservice_loop_io_uring_enter(io_uring, timeout))
+		return false;
 
-	aprs_packet_deinit(packet);
+	aprservice_loop_io_uring_complete(io_uring);
 
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send_weather(struct aprservice* service, uint16_t wind_speed, uint16_t wind_speed_gust, uint16_t wind_direction, uint16_t rainfall_last_hour, uint16_t rainfall_last_24_hours, uint16_t rainfall_since_midnight, uint8_t humidity, int16_t temperature, uint32_t barometric_pressure, const char* type, char software)
+int                                        aprservice_loop_io_uring_read(aprservice_connection* connection, void* buffer, size_t size, size_t* number_of_bytes_received)
 {
-	if (!aprservice_is_connected(service))
-		return false;
+	auto entry = connection->service->loop_entry;
+	auto watch = entry ? entry->io_uring_watch : nullptr;
 
-	if (aprservice_is_read_only(service))
-		return false;
+	if (!watch || !watch->is_socket)
+		return -2;
 
-	aprs_packet* packet;
+	auto io_uring = watch->io_uring;
 
-	if (!(packet = aprs_packet_weather_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), type, software)))
+	*number_of_bytes_received = 0;
+
+	while (!watch->rx.empty() && (*number_of_bytes_received < size))
 	{
-		aprservice_log_error(aprs_packet_weather_init, nullptr);
+		auto rx     = &watch->rx.front();
+		auto length = std::min<size_t>(size - *number_of_bytes_received, rx->size - rx->offset);
 
-		return false;
-	}
+		memcpy((char*)buffer + *number_of_bytes_received, &io_uring->buffers[(rx->id * APRSERVICE_LOOP_IO_URING_BUFFER_SIZE) + rx->offset], length);
 
-	if (!aprs_packet_weather_set_wind_speed(packet, wind_speed))
-	{
-		aprservice_log_error(aprs_packet_weather_set_wind_speed, false);
+		*number_of_bytes_received += length;
 
-		aprs_packet_deinit(packet);
+		if ((rx->offset += length) == rx->size)
+		{
+			aprservice_loop_io_uring_add_buffer(io_uring, rx->id);
 
-		return false;
+			watch->rx.pop_front();
+		}
 	}
 
-	if (!aprs_packet_weather_set_wind_speed_gust(packet, wind_speed_gust))
-	{
-		aprservice_log_error(aprs_packet_weather_set_wind_speed_gust, false);
-
-		aprs_packet_deinit(packet);
+	if (watch->rx.empty() && !watch->is_reading && !watch->is_closed && !aprservice_loop_io_uring_submit_read(watch))
+		watch->is_closed = true;
 
-		return false;
-	}
+	if (*number_of_bytes_received)
+		return 1;
 
-	if (!aprs_packet_weather_set_wind_direction(packet, wind_direction))
+	if (watch->is_closed)
 	{
-		aprservice_log_error(aprs_packet_weather_set_wind_direction, false);
-
-		aprs_packet_deinit(packet);
+		aprservice_connection_close(connection);
 
-		return false;
+		return 0;
 	}
 
-	if (!aprs_packet_weather_set_rainfall_last_hour(packet, rainfall_last_hour))
+	return -1;
+}
+#endif
+
+// @return -1 if connection can not be waited on by a loop
+int                                        aprservice_loop_get_fd(aprservice_connection* connection)
+{
+#if defined(APRSERVICE_UNIX)
+	return (connection->type == APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL) ? connection->serial : connection->socket;
+#else
+	return -1;
+#endif
+}
+// @return false on error
+bool                                       aprservice_loop_watch(aprservice_loop_entry* entry, int fd, bool write, [[maybe_unused]] bool is_socket)
+{
+#if defined(APRSERVICE_LOOP_IO_URING)
+	if (entry->loop->io_uring)
 	{
-		aprservice_log_error(aprs_packet_weather_set_rainfall_last_hour, false);
+		if (!aprservice_loop_io_uring_add(entry, fd, write, is_socket))
+			return false;
 
-		aprs_packet_deinit(packet);
+		entry->fd       = fd;
+		entry->fd_write = write;
 
-		return false;
+		return true;
 	}
+#endif
 
-	if (!aprs_packet_weather_set_rainfall_last_24_hours(packet, rainfall_last_24_hours))
+#if defined(APRSERVICE_LOOP_EPOLL)
+	epoll_event event = { .events = write ? (EPOLLIN | EPOLLOUT) : EPOLLIN, .data = { .ptr = entry } };
+
+	if (epoll_ctl(entry->loop->fd, (entry->fd == -1) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event) == -1)
 	{
-		aprservice_log_error(aprs_packet_weather_set_rainfall_last_24_hours, false);
+		auto error = errno;
 
-		aprs_packet_deinit(packet);
+		aprservice_log_error(epoll_ctl, error);
 
 		return false;
 	}
+#elif defined(APRSERVICE_LOOP_KQUEUE)
+	struct kevent events[2];
+	int           events_size = 0;
 
-	if (!aprs_packet_weather_set_rainfall_since_midnight(packet, rainfall_since_midnight))
-	{
-		aprservice_log_error(aprs_packet_weather_set_rainfall_since_midnight, false);
-
-		aprs_packet_deinit(packet);
+	if (entry->fd == -1)
+		EV_SET(&events[events_size++], fd, EVFILT_READ, EV_ADD, 0, 0, entry);
 
-		return false;
-	}
+	if (write != ((entry->fd != -1) && entry->fd_write))
+		EV_SET(&events[events_size++], fd, EVFILT_WRITE, write ? EV_ADD : EV_DELETE, 0, 0, entry);
 
-	if (!aprs_packet_weather_set_humidity(packet, humidity))
+	if (events_size && (kevent(entry->loop->fd, events, events_size, nullptr, 0, nullptr) == -1))
 	{
-		aprservice_log_error(aprs_packet_weather_set_humidity, false);
+		auto error = errno;
 
-		aprs_packet_deinit(packet);
+		aprservice_log_error(kevent, error);
 
 		return false;
 	}
+#endif
 
-	if (!aprs_packet_weather_set_temperature(packet, temperature))
+	entry->fd       = fd;
+	entry->fd_write = write;
+
+	return true;
+}
+void                                       aprservice_loop_unwatch(aprservice_loop_entry* entry)
+{
+	if (entry->fd != -1)
 	{
-		aprservice_log_error(aprs_packet_weather_set_temperature, false);
+#if defined(APRSERVICE_LOOP_IO_URING)
+		if (entry->loop->io_uring)
+			aprservice_loop_io_uring_remove(entry);
+		else
+#endif
+#if defined(APRSERVICE_LOOP_EPOLL)
+		epoll_ctl(entry->loop->fd, EPOLL_CTL_DEL, entry->fd, nullptr);
+#elif defined(APRSERVICE_LOOP_KQUEUE)
+		struct kevent events[2];
+		int           events_size = 0;
 
-		aprs_packet_deinit(packet);
+		EV_SET(&events[events_size++], entry->fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
 
-		return false;
-	}
+		if (entry->fd_write)
+			EV_SET(&events[events_size++], entry->fd, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
 
-	if (!aprs_packet_weather_set_barometric_pressure(packet, barometric_pressure))
+		kevent(entry->loop->fd, events, events_size, nullptr, 0, nullptr);
+#endif
+
+		entry->fd       = -1;
+		entry->fd_write = false;
+	}
+}
+void                                       aprservice_loop_unwatch(aprservice* service)
+{
+	if (auto entry = service->loop_entry)
 	{
-		aprservice_log_error(aprs_packet_weather_set_barometric_pressure, false);
+		aprservice_loop_unwatch(entry);
+		aprservice_loop_wake(service);
+	}
+}
+void                                       aprservice_loop_wake(aprservice* service)
+{
+	if (auto entry = service->loop_entry; entry && !entry->is_pending)
+	{
+		entry->is_pending = true;
+		entry->loop->pending.push_back(entry);
+	}
+}
+void                                       aprservice_loop_ready(aprservice_loop_entry* entry, bool is_readable, bool is_writable)
+{
+	if (!entry->is_ready)
+	{
+		entry->is_ready = true;
+		entry->loop->ready.push_back(entry);
+	}
 
-		aprs_packet_deinit(packet);
+	entry->is_readable |= is_readable;
+	entry->is_writable |= is_writable;
+}
+// marks every service with io as ready
+// @return false on error
+bool                                       aprservice_loop_wait(aprservice_loop* loop, uint32_t timeout)
+{
+#if defined(APRSERVICE_LOOP_IO_URING)
+	if (loop->io_uring)
+		return aprservice_loop_io_uring_wait(loop->io_uring, timeout);
+#endif
 
-		return false;
-	}
+#if defined(APRSERVICE_LOOP_EPOLL)
+	epoll_event events[APRSERVICE_LOOP_EVENT_COUNT];
+	int         events_size;
 
-	if (!aprservice_send(service, packet))
+	if ((events_size = epoll_wait(loop->fd, events, APRSERVICE_LOOP_EVENT_COUNT, (int)timeout)) == -1)
 	{
-		aprservice_log_error(aprservice_send, false);
+		auto error = errno;
 
-		aprs_packet_deinit(packet);
+		if (error != EINTR)
+		{
+			aprservice_log_error(epoll_wait, error);
 
-		return false;
+			return false;
+		}
+
+		events_size = 0;
 	}
 
-	aprs_packet_deinit(packet);
+	for (int i = 0; i < events_size; ++i)
+		aprservice_loop_ready((aprservice_loop_entry*)events[i].data.ptr, events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR), events[i].events & EPOLLOUT);
+#elif defined(APRSERVICE_LOOP_KQUEUE)
+	struct kevent   events[APRSERVICE_LOOP_EVENT_COUNT];
+	int             events_size;
+	struct timespec events_timeout = { .tv_sec = timeout / 1000, .tv_nsec = (timeout % 1000) * 1000000l };
 
-	return true;
-}
-bool                       APRSERVICE_CALL aprservice_send_position(struct aprservice* service)
-{
-	if (!aprservice_is_connected(service))
-		return false;
+	if ((events_size = kevent(loop->fd, nullptr, 0, events, APRSERVICE_LOOP_EVENT_COUNT, &events_timeout)) == -1)
+	{
+		auto error = errno;
 
-	if (aprservice_is_read_only(service))
-		return false;
+		if (error != EINTR)
+		{
+			aprservice_log_error(kevent, error);
 
-	if (!aprservice_send(service, service->position))
-	{
-		aprservice_log_error(aprservice_send, false);
+			return false;
+		}
 
-		return false;
+		events_size = 0;
 	}
 
+	for (int i = 0; i < events_size; ++i)
+		aprservice_loop_ready((aprservice_loop_entry*)events[i].udata, events[i].filter == EVFILT_READ, events[i].filter == EVFILT_WRITE);
+#endif
+
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send_position_ex(struct aprservice* service, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course, const char* comment)
+// registers the fd of service for the io it is waiting on and schedules its next deadline
+void                                       aprservice_loop_update(aprservice_loop_entry* entry)
 {
-	if (!aprservice_is_connected(service))
-		return false;
+	auto service    = entry->service;
+	auto connection = service->connection;
+	auto time       = aprservice_get_time_ms(service);
+	auto deadline   = aprservice_task_wheel_get_next_time(&service->tasks);
 
-	if (aprservice_is_read_only(service))
-		return false;
+	entry->is_pending = false;
 
-	aprs_packet* packet;
+	if (!service->message_callbacks.heap.empty())
+		deadline = std::min(deadline, service->message_callbacks.heap.front()->timeout);
 
-	if (!(packet = aprs_packet_position_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), latitude, longitude, altitude, speed, course, comment, aprservice_get_symbol_table(service), aprservice_get_symbol_table_key(service), aprservice_get_time_type(service))))
+	if (!connection)
+		aprservice_loop_unwatch(entry);
+	else if (!aprservice_connection_is_open(connection))
 	{
-		aprservice_log_error(aprs_packet_position_init, nullptr);
+		// closed but not yet disconnected
+		aprservice_loop_unwatch(entry);
 
-		return false;
+		deadline = time;
 	}
+	else
+	{
+		auto airtime_wait = aprservice_connection_airtime_get_wait(connection);
+		bool will_write   = !connection->tx_queue.empty() || (connection->tx_pending_size && !airtime_wait);
 
-	aprs_packet_position_enable_messaging(packet, true);
-	aprs_packet_position_enable_compression(packet, aprs_packet_position_is_compressed(service->position));
+		if (airtime_wait)
+			deadline = std::min(deadline, time + airtime_wait);
 
-	if (!aprservice_send(service, packet))
-	{
-		aprservice_log_error(aprservice_send, false);
+		deadline = std::min<uint64_t>(deadline, connection->io_time + (service->connection_timeout * 1000ull));
 
-		aprs_packet_deinit(packet);
+		if (auto fd = aprservice_loop_get_fd(connection); ((fd != entry->fd) || (will_write != entry->fd_write)) && !aprservice_loop_watch(entry, fd, will_write, connection->type != APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL))
+		{
+			// disconnected by aprservice_loop_dispatch
+			aprservice_connection_close(connection);
 
-		return false;
+			deadline = time;
+		}
 	}
 
-	aprs_packet_deinit(packet);
+	if (entry->deadline != entry->loop->deadlines.end())
+	{
+		entry->loop->deadlines.erase(entry->deadline);
+		entry->deadline = entry->loop->deadlines.end();
+	}
 
-	return true;
+	if (deadline != UINT64_MAX)
+		entry->deadline = entry->loop->deadlines.emplace(aprservice_loop_get_time_ms() + ((deadline > time) ? (deadline - time) : 0), entry);
 }
-bool                       APRSERVICE_CALL aprservice_send_telemetry(struct aprservice* service, uint8_t a1, uint8_t a2, uint8_t a3, uint8_t a4, uint8_t a5, uint8_t digital)
+// does the work of aprservice_wait_for_io and aprservice_poll for a service that is ready or has reached its deadline
+void                                       aprservice_loop_dispatch(aprservice_loop_entry* entry)
 {
-	if (service->telemetry_count++ == 999)
-		service->telemetry_count = 0;
+	auto service = entry->service;
 
-	return aprservice_send_telemetry_ex(service, a1, a2, a3, a4, a5, digital, aprservice_get_comment(service), service->telemetry_count);
-}
-bool                       APRSERVICE_CALL aprservice_send_telemetry_ex(struct aprservice* service, uint8_t a1, uint8_t a2, uint8_t a3, uint8_t a4, uint8_t a5, uint8_t digital, const char* comment, uint16_t sequence)
-{
-	if (!aprservice_is_connected(service))
-		return false;
+	entry->is_ready = false;
 
-	if (aprservice_is_read_only(service))
-		return false;
+	if (auto connection = service->connection)
+	{
+		if (!aprservice_connection_is_open(connection) || !aprservice_connection_flush(connection))
+			aprservice_disconnect(service);
+		else if (entry->is_readable || entry->is_writable)
+			connection->io_time = aprservice_get_time_ms(service);
+		else if ((aprservice_get_time_ms(service) - connection->io_time) >= (service->connection_timeout * 1000ull))
+			aprservice_disconnect(service);
+	}
 
-	aprs_packet* packet;
+	entry->is_readable = false;
+	entry->is_writable = false;
 
-	if (!(packet = aprs_packet_telemetry_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), a1, a2, a3, a4, a5, digital, sequence)))
+	// handlers may remove or deinit service
+	if (entry->service)
+		aprservice_poll(service);
+
+	if (entry->service)
+		aprservice_loop_update(entry);
+}
+
+struct aprservice_loop*    APRSERVICE_CALL aprservice_loop_init()
+{
+	auto loop = new aprservice_loop
 	{
-		aprservice_log_error(aprs_packet_telemetry_init, nullptr);
+		.is_polling      = false,
 
-		return false;
-	}
+		.fd              = -1,
+#if defined(APRSERVICE_LOOP_IO_URING)
+		.io_uring        = nullptr,
+#endif
+
+		.entries_removed = 0
+	};
 
-	if (comment && !aprs_packet_telemetry_set_comment(packet, comment))
+#if defined(APRSERVICE_LOOP_IO_URING)
+	// falls back to epoll if the kernel is missing anything that is needed
+	if ((loop->io_uring = aprservice_loop_io_uring_init()))
+		return loop;
+#endif
+
+#if defined(APRSERVICE_LOOP_EPOLL)
+	if ((loop->fd = epoll_create1(EPOLL_CLOEXEC)) == -1)
 	{
-		aprservice_log_error(aprs_packet_telemetry_set_comment, false);
+		auto error = errno;
 
-		aprs_packet_deinit(packet);
+		aprservice_log_error(epoll_create1, error);
 
-		return false;
-	}
+		delete loop;
 
-	if (!aprservice_send(service, packet))
+		return nullptr;
+	}
+#elif defined(APRSERVICE_LOOP_KQUEUE)
+	if ((loop->fd = kqueue()) == -1)
 	{
-		aprservice_log_error(aprservice_send, false);
+		auto error = errno;
 
-		aprs_packet_deinit(packet);
+		aprservice_log_error(kqueue, error);
 
-		return false;
+		delete loop;
+
+		return nullptr;
 	}
+#else
+	aprservice_log_error(aprservice_loop_init, "not supported");
 
-	aprs_packet_deinit(packet);
+	delete loop;
 
-	return true;
-}
-bool                       APRSERVICE_CALL aprservice_send_telemetry_float(struct aprservice* service, float a1, float a2, float a3, float a4, float a5, uint8_t digital)
-{
-	if (service->telemetry_count++ == 999)
-		service->telemetry_count = 0;
+	return nullptr;
+#endif
 
-	return aprservice_send_telemetry_float_ex(service, a1, a2, a3, a4, a5, digital, aprservice_get_comment(service), service->telemetry_count);
+	return loop;
 }
-bool                       APRSERVICE_CALL aprservice_send_telemetry_float_ex(struct aprservice* service, float a1, float a2, float a3, float a4, float a5, uint8_t digital, const char* comment, uint16_t sequence)
+void                       APRSERVICE_CALL aprservice_loop_deinit(struct aprservice_loop* loop)
 {
-	if (!aprservice_is_connected(service))
-		return false;
-
-	if (aprservice_is_read_only(service))
-		return false;
+	for (auto& entry : loop->entries)
+		if (entry.service)
+			entry.service->loop_entry = nullptr;
 
-	aprs_packet* packet;
+#if defined(APRSERVICE_LOOP_IO_URING)
+	if (loop->io_uring)
+		aprservice_loop_io_uring_deinit(loop->io_uring);
+#endif
 
-	if (!(packet = aprs_packet_telemetry_init_float(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), a1, a2, a3, a4, a5, digital, sequence)))
-	{
-		aprservice_log_error(aprs_packet_telemetry_init_float, nullptr);
+#if defined(APRSERVICE_UNIX)
+	if (loop->fd != -1)
+		close(loop->fd);
+#endif
 
+	delete loop;
+}
+bool                       APRSERVICE_CALL aprservice_loop_is_io_uring_enabled([[maybe_unused]] struct aprservice_loop* loop)
+{
+#if defined(APRSERVICE_LOOP_IO_URING)
+	return loop->io_uring != nullptr;
+#else
+	return false;
+#endif
+}
+size_t                     APRSERVICE_CALL aprservice_loop_get_size(struct aprservice_loop* loop)
+{
+	return loop->entries.size() - loop->entries_removed;
+}
+bool                       APRSERVICE_CALL aprservice_loop_add(struct aprservice_loop* loop, struct aprservice* service)
+{
+	if (service->loop_entry)
 		return false;
-	}
 
-	if (comment && !aprs_packet_telemetry_set_comment(packet, comment))
+	auto entry = &loop->entries.emplace_back(aprservice_loop_entry
 	{
-		aprservice_log_error(aprs_packet_telemetry_set_comment, false);
+		.loop           = loop,
+		.service        = service,
 
-		aprs_packet_deinit(packet);
+		.is_pending     = false,
+		.is_ready       = false,
+		.is_readable    = false,
+		.is_writable    = false,
 
-		return false;
-	}
+		.fd             = -1,
+		.fd_write       = false,
 
-	if (!aprservice_send(service, packet))
-	{
-		aprservice_log_error(aprservice_send, false);
+		.deadline       = loop->deadlines.end(),
 
-		aprs_packet_deinit(packet);
+#if defined(APRSERVICE_LOOP_IO_URING)
+		.io_uring_watch = nullptr
+#endif
+	});
 
-		return false;
-	}
+	service->loop_entry = entry;
 
-	aprs_packet_deinit(packet);
+	aprservice_loop_wake(service);
 
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send_user_defined(struct aprservice* service, char id, char type, const char* data)
+bool                       APRSERVICE_CALL aprservice_loop_remove(struct aprservice_loop* loop, struct aprservice* service)
 {
-	if (!aprservice_is_connected(service))
-		return false;
+	auto entry = service->loop_entry;
 
-	if (aprservice_is_read_only(service))
+	if (!entry || (entry->loop != loop))
 		return false;
 
-	aprs_packet* packet;
+	aprservice_loop_unwatch(entry);
 
-	if (!(packet = aprs_packet_user_defined_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service), id, type, data)))
-	{
-		aprservice_log_error(aprs_packet_user_defined_init, nullptr);
+	if (entry->deadline != loop->deadlines.end())
+		loop->deadlines.erase(entry->deadline);
 
-		return false;
-	}
+	entry->service      = nullptr;
+	entry->deadline     = loop->deadlines.end();
+	service->loop_entry = nullptr;
 
-	if (!aprservice_send(service, packet))
-	{
-		aprservice_log_error(aprservice_send, false);
+	// events already received may still point to entry
+	++loop->entries_removed;
 
-		aprs_packet_deinit(packet);
+	if (!loop->is_polling)
+	{
+		std::erase_if(loop->pending, [](aprservice_loop_entry* entry) { return !entry->service; });
 
-		return false;
+		loop->entries.remove_if([](aprservice_loop_entry& entry) { return !entry.service; });
+		loop->entries_removed = 0;
 	}
 
-	aprs_packet_deinit(packet);
-
 	return true;
 }
-bool                       APRSERVICE_CALL aprservice_send_third_party(struct aprservice* service, const char* content)
+bool                       APRSERVICE_CALL aprservice_loop_poll(struct aprservice_loop* loop, uint32_t timeout)
 {
-	if (!aprservice_is_connected(service))
+	if (loop->is_polling)
 		return false;
 
-	if (aprservice_is_read_only(service))
-		return false;
+	loop->is_polling = true;
 
-	aprs_packet* packet;
+	// updates may close a connection and wake its service again
+	for (size_t i = 0; i < loop->pending.size(); ++i)
+		if (auto entry = loop->pending[i]; entry->service && entry->is_pending)
+			aprservice_loop_update(entry);
 
-	if (!(packet = aprs_packet_third_party_init(aprservice_get_station(service), APRSERVICE_TOCALL, aprservice_get_path(service))))
+	loop->pending.clear();
+
+	if (!loop->deadlines.empty())
 	{
-		aprservice_log_error(aprs_packet_third_party_init, nullptr);
+		auto time     = aprservice_loop_get_time_ms();
+		auto deadline = loop->deadlines.begin()->first;
 
-		return false;
+		timeout = (deadline > time) ? (uint32_t)std::min<uint64_t>(deadline - time, timeout) : 0;
 	}
 
-	if (!aprs_packet_third_party_set_content(packet, content))
+	bool success = aprservice_loop_wait(loop, timeout);
+
+	for (auto time = aprservice_loop_get_time_ms(); !loop->deadlines.empty() && (loop->deadlines.begin()->first <= time); )
 	{
-		aprservice_log_error(aprs_packet_third_party_set_content, false);
+		auto entry = loop->deadlines.begin()->second;
 
-		aprs_packet_deinit(packet);
+		loop->deadlines.erase(loop->deadlines.begin());
+		entry->deadline = loop->deadlines.end();
 
-		return false;
+		aprservice_loop_ready(entry, false, false);
 	}
 
-	if (!aprservice_send(service, packet))
-	{
-		aprservice_log_error(aprservice_send, false);
+	for (size_t i = 0; i < loop->ready.size(); ++i)
+		if (auto entry = loop->ready[i]; entry->service && entry->is_ready)
+			aprservice_loop_dispatch(entry);
 
-		aprs_packet_deinit(packet);
+	loop->ready.clear();
+	loop->is_polling = false;
 
-		return false;
-	}
+	if (loop->entries_removed)
+	{
+		std::erase_if(loop->pending, [](aprservice_loop_entry* entry) { return !entry->service; });
 
-	aprs_packet_deinit(packet);
+		loop->entries.remove_if([](aprservice_loop_entry& entry) { return !entry.service; });
+		loop->entries_removed = 0;
+	}
 
-	return true;
+	return success;
 }
-bool                       APRSERVICE_CALL aprservice_connect_aprs_is(struct aprservice* service, const char* hostname, uint16_t port, uint16_t passcode)
-{
-	if (aprservice_is_connected(service))
-		return false;
 
-	if (!(service->connection = aprservice_connection_init(service, APRSERVICE_CONNECTION_TYPE_APRS_IS, hostname, port, 0, passcode)))
+APRSERVICE_PRIORITIES                      aprservice_get_packet_priority(struct aprs_packet* packet)
+{
+	switch (aprs_packet_get_type(packet))
 	{
-		// aprservice_log_error(aprservice_connection_init, nullptr);
+		case APRS_PACKET_TYPE_MESSAGE:
+			switch (aprs_packet_message_get_type(packet))
+			{
+				case APRS_MESSAGE_TYPE_ACK:
+				case APRS_MESSAGE_TYPE_REJECT:
+					return APRSERVICE_PRIORITY_ACK;
 
-		return false;
+				case APRS_MESSAGE_TYPE_BULLETIN:
+					return APRSERVICE_PRIORITY_BULK;
+			}
+			return APRSERVICE_PRIORITY_MESSAGE;
+
+		case APRS_PACKET_TYPE_ITEM:
+		case APRS_PACKET_TYPE_OBJECT:
+			return APRSERVICE_PRIORITY_BULK;
 	}
 
-	if (!aprservice_connection_open(service->connection))
-	{
-		// aprservice_log_error(aprservice_connection_open, false);
+	return APRSERVICE_PRIORITY_BEACON;
+}
 
-		aprservice_connection_deinit(service->connection);
+std::string                                aprservice_command_key(std::string_view name)
+{
+	std::string key(name);
 
-		service->connection = nullptr;
+	for (auto& c : key)
+		if ((c >= 'A') && (c <= 'Z'))
+			c += 'a' - 'A';
 
-		return false;
-	}
+	return key;
+}
+// @return nullptr if not found
+aprservice_command*                        aprservice_command_find(struct aprservice* service, std::string_view name, bool ignore_case)
+{
+	aprservice_command* match = nullptr;
 
-	return true;
+	for (auto [it, end] = service->commands.equal_range(aprservice_command_key(name)); it != end; ++it)
+		if (!it->second.name.compare(name))
+			return &it->second;
+		else if (ignore_case && !match)
+			match = &it->second;
+
+	return match;
 }
-bool                       APRSERVICE_CALL aprservice_connect_kiss_tnc_tcp(struct aprservice* service, const char* hostname, uint16_t port)
+bool                                       aprservice_parse_command(std::string_view content, std::string_view prefix, std::string_view& name, const char*& args)
 {
-	if (aprservice_is_connected(service))
+	if (!content.starts_with(prefix))
 		return false;
 
-	if (!(service->connection = aprservice_connection_init(service, APRSERVICE_CONNECTION_TYPE_KISS_TNC_TCP, hostname, port, 0, 0)))
-	{
-		// aprservice_log_error(aprservice_connection_init, nullptr);
+	auto i = prefix.length();
+	auto j = i;
 
-		return false;
-	}
+	while ((j < content.length()) && (content[j] != ' '))
+		++j;
 
-	if (!aprservice_connection_open(service->connection))
-	{
-		// aprservice_log_error(aprservice_connection_open, false);
+	name = content.substr(i, j - i);
 
-		aprservice_connection_deinit(service->connection);
+	while ((j < content.length()) && (content[j] == ' '))
+		++j;
 
-		service->connection = nullptr;
+	// content is null terminated so args is too
+	args = content.data() + j;
 
-		return false;
-	}
+	return !name.empty();
+}
+bool                                       aprservice_execute_command(struct aprservice* service, struct aprs_packet* packet, const char* sender, std::string_view name, const char* args)
+{
+	if (auto command = aprservice_command_find(service, name, service->is_command_case_folding))
+		if (!command->filter || command->filter(service, command, packet, sender, command->name.c_str(), args, command->filter_param))
+			return command->handler(service, command, packet, sender, command->name.c_str(), args, command->handler_param), true;
 
-	return true;
+	return false;
 }
-bool                       APRSERVICE_CALL aprservice_connect_kiss_tnc_serial(struct aprservice* service, const char* device, uint32_t speed)
+
+// @return milliseconds until the next steady announcement
+uint32_t                                   aprservice_announcer_get_delay(struct aprservice* service, aprservice_announcer* announcer)
 {
-	if (aprservice_is_connected(service))
-		return false;
+	uint64_t period = service->announce_period * 1000ull;
+	// golden ratio sequence, any number of announcers stays evenly spread
+	uint64_t offset = ((uint64_t)(uint32_t)(announcer->sequence * 2654435769u) * period) >> 32;
+	uint64_t delay  = (offset + period - (aprservice_get_time_ms(service) % period)) % period;
 
-	if (!(service->connection = aprservice_connection_init(service, APRSERVICE_CONNECTION_TYPE_KISS_TNC_SERIAL, device, 0, speed, 0)))
-	{
-		// aprservice_log_error(aprservice_connection_init, nullptr);
+	return (uint32_t)(delay ? delay : period);
+}
+void                                       aprservice_announcer_start(struct aprservice* service, aprservice_announcer* announcer, aprservice_task_handler handler, void* param, bool is_changed)
+{
+	aprservice_announcer_stop(announcer);
 
-		return false;
-	}
+	if (!service->announce_period)
+		return;
 
-	if (!aprservice_connection_open(service->connection))
+	uint32_t delay;
+
+	if (!is_changed)
 	{
-		// aprservice_log_error(aprservice_connection_open, false);
+		announcer->interval = service->announce_period * 1000;
 
-		aprservice_connection_deinit(service->connection);
+		delay = aprservice_announcer_get_delay(service, announcer);
+	}
+	else
+	{
+		auto time = aprservice_get_time_ms(service);
 
-		service->connection = nullptr;
+		announcer->interval = APRSERVICE_ANNOUNCER_INTERVAL;
 
-		return false;
+		if (!announcer->time || ((announcer->time + APRSERVICE_ANNOUNCER_INTERVAL) <= time))
+			delay = 0;
+		else
+			delay = (uint32_t)((announcer->time + APRSERVICE_ANNOUNCER_INTERVAL) - time);
 	}
 
-	return true;
+	announcer->task = aprservice_task_schedule_ms(service, delay, handler, param);
 }
-void                       APRSERVICE_CALL aprservice_disconnect(struct aprservice* service)
+void                                       aprservice_announcer_stop(aprservice_announcer* announcer)
 {
-	if (aprservice_is_connected(service))
+	if (announcer->task)
 	{
-		aprservice_connection_deinit(service->connection);
-		service->connection = nullptr;
+		aprservice_task_cancel(announcer->task);
 
-		service->message_callbacks.remove_if([service](aprservice_message_callback_context* context) {
-			context->callback(service, APRSERVICE_MESSAGE_ERROR_DISCONNECTED, context->callback_param);
+		announcer->task = nullptr;
+	}
+}
+bool                                       aprservice_announcer_update(struct aprservice* service, aprservice_announcer* announcer, struct aprservice_task_information* task, bool is_alive)
+{
+	uint32_t period = service->announce_period * 1000;
 
-			return true;
-		});
+	announcer->time = aprservice_get_time_ms(service);
 
-		service->message_callbacks_index.clear();
+	if (announcer->interval < period)
+	{
+		task->milliseconds  = announcer->interval;
+		announcer->interval = (uint32_t)std::min<uint64_t>(announcer->interval * 2ull, period);
 	}
-}
+	// a kill is only repeated until the decay is over
+	else if (!is_alive)
+		return false;
+	else
+		task->milliseconds = aprservice_announcer_get_delay(service, announcer);
 
-int                        APRSERVICE_CALL aprservice_wait_for_io(struct aprservice* service, uint32_t timeout)
+	task->reschedule = true;
+
+	return true;
+}
+void                       APRSERVICE_CALL aprservice_item_announcer_handler(struct aprservice* service, struct aprservice_task_information* task, void* param)
 {
-	if (!aprservice_is_connected(service))
-		return 0;
+	auto item = (aprservice_item*)param;
 
-	switch (aprservice_connection_wait_for_io(service->connection, timeout))
+	if (task->is_canceled)
 	{
-		case 0:
-			aprservice_disconnect(service);
-			return 0;
-
-		case -1:
-			return -1;
+		item->announcer.task = nullptr;
 
-		case -2:
-			aprservice_disconnect(service);
-			return -2;
+		return;
 	}
 
-	return 1;
-}
+	if (aprservice_is_connected(service) && !aprservice_is_read_only(service))
+		aprservice_item_announce(item);
 
-bool                                       aprservice_execute_command(struct aprservice* service, struct aprs_packet* packet, const char* sender, std::string_view name, const char* args)
+	if (!aprservice_announcer_update(service, &item->announcer, task, aprservice_item_is_alive(item)))
+		item->announcer.task = nullptr;
+}
+void                       APRSERVICE_CALL aprservice_object_announcer_handler(struct aprservice* service, struct aprservice_task_information* task, void* param)
 {
-	for (auto& command : service->commands)
-		if (!command.name.compare(name))
-		{
-			if (!command.filter || command.filter(service, &command, packet, sender, command.name.c_str(), args, command.filter_param))
-				return command.handler(service, &command, packet, sender, command.name.c_str(), args, command.handler_param), true;
+	auto object = (aprservice_object*)param;
 
-			break;
-		}
+	if (task->is_canceled)
+	{
+		object->announcer.task = nullptr;
 
-	return false;
+		return;
+	}
+
+	if (aprservice_is_connected(service) && !aprservice_is_read_only(service))
+		aprservice_object_announce(object);
+
+	if (!aprservice_announcer_update(service, &object->announcer, task, aprservice_object_is_alive(object)))
+		object->announcer.task = nullptr;
 }
 
-struct aprservice_task*    APRSERVICE_CALL aprservice_task_schedule(struct aprservice* service, uint32_t seconds, aprservice_task_handler handler, void* param)
+struct aprservice_task*                    aprservice_task_schedule_ex(struct aprservice* service, uint64_t milliseconds, bool is_milliseconds, aprservice_task_handler handler, void* param)
 {
 	auto task = new aprservice_task
 	{
-		.service       = service,
+		.service         = service,
 
-		.seconds       = seconds,
-		.handler       = handler,
-		.handler_param = param
+		.is_running      = false,
+		.is_canceled     = false,
+		.is_milliseconds = is_milliseconds,
+
+		.time            = aprservice_get_time_ms(service) + milliseconds,
+		.milliseconds    = milliseconds,
+		.handler         = handler,
+		.handler_param   = param
 	};
 
-	service->tasks[aprservice_get_time(service) + seconds].push_back(task);
+	aprservice_task_wheel_insert(&service->tasks, task);
+
+	++service->tasks.size;
+
+	aprservice_loop_wake(service);
 
 	return task;
 }
+struct aprservice_task*    APRSERVICE_CALL aprservice_task_schedule(struct aprservice* service, uint32_t seconds, aprservice_task_handler handler, void* param)
+{
+	return aprservice_task_schedule_ex(service, seconds * 1000ull, false, handler, param);
+}
+struct aprservice_task*    APRSERVICE_CALL aprservice_task_schedule_ms(struct aprservice* service, uint32_t milliseconds, aprservice_task_handler handler, void* param)
+{
+	return aprservice_task_schedule_ex(service, milliseconds, true, handler, param);
+}
 void                       APRSERVICE_CALL aprservice_task_cancel(struct aprservice_task* task)
 {
-	if (auto service = aprservice_task_get_service(task))
+	// deleted by aprservice_poll_tasks once the handler returns
+	if (task->is_running)
+		task->is_canceled = true;
+	else
 	{
-		for (auto it = service->tasks.begin(); it != service->tasks.end(); ++it)
-		{
-			for (auto jt = it->second.begin(); jt != it->second.end(); ++jt)
-			{
-				if (*jt == task)
-				{
-					it->second.erase(jt);
+		aprservice_task_link_remove(&task->link);
 
-					delete task;
+		--task->service->tasks.size;
 
-					if (it->second.empty())
-						service->tasks.erase(it);
-
-					break;
-				}
-			}
-		}
+		delete task;
 	}
 }
 void                       APRSERVICE_CALL aprservice_task_get_handler(struct aprservice_task* task, aprservice_task_handler* handler, void** param)
@@ -3123,7 +5607,13 @@ struct aprservice_item*    APRSERVICE_CALL aprservice_item_create(struct aprserv
 		return nullptr;
 	};
 
-	return &service->items.emplace_back(std::move(item));
+	auto result = &service->items.emplace_back(std::move(item));
+
+	result->announcer.sequence = service->announce_sequence++;
+
+	aprservice_announcer_start(service, &result->announcer, &aprservice_item_announcer_handler, result, true);
+
+	return result;
 }
 void                       APRSERVICE_CALL aprservice_item_destroy(struct aprservice_item* item)
 {
@@ -3131,6 +5621,8 @@ void                       APRSERVICE_CALL aprservice_item_destroy(struct aprser
 		for (auto it = service->items.begin(); it != service->items.end(); ++it)
 			if (&*it == item)
 			{
+				aprservice_announcer_stop(&item->announcer);
+
 				aprs_packet_deinit(item->packet);
 
 				service->items.erase(it);
@@ -3195,6 +5687,8 @@ bool                       APRSERVICE_CALL aprservice_item_set_symbol(struct apr
 		return false;
 	}
 
+	aprservice_announcer_start(item->service, &item->announcer, &aprservice_item_announcer_handler, item, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_item_set_comment(struct aprservice_item* item, const char* value)
@@ -3206,6 +5700,8 @@ bool                       APRSERVICE_CALL aprservice_item_set_comment(struct ap
 		return false;
 	}
 
+	aprservice_announcer_start(item->service, &item->announcer, &aprservice_item_announcer_handler, item, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_item_set_position(struct aprservice_item* item, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course)
@@ -3245,6 +5741,8 @@ bool                       APRSERVICE_CALL aprservice_item_set_position(struct a
 		return false;
 	}
 
+	aprservice_announcer_start(item->service, &item->announcer, &aprservice_item_announcer_handler, item, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_item_set_compressed(struct aprservice_item* item, bool value)
@@ -3256,6 +5754,8 @@ bool                       APRSERVICE_CALL aprservice_item_set_compressed(struct
 		return false;
 	}
 
+	aprservice_announcer_start(item->service, &item->announcer, &aprservice_item_announcer_handler, item, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_item_kill(struct aprservice_item* item)
@@ -3270,6 +5770,8 @@ bool                       APRSERVICE_CALL aprservice_item_kill(struct aprservic
 		return false;
 	}
 
+	aprservice_announcer_start(item->service, &item->announcer, &aprservice_item_announcer_handler, item, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_item_announce(struct aprservice_item* item)
@@ -3370,7 +5872,13 @@ struct aprservice_object*  APRSERVICE_CALL aprservice_object_create(struct aprse
 		return nullptr;
 	};
 
-	return &service->objects.emplace_back(std::move(object));
+	auto result = &service->objects.emplace_back(std::move(object));
+
+	result->announcer.sequence = service->announce_sequence++;
+
+	aprservice_announcer_start(service, &result->announcer, &aprservice_object_announcer_handler, result, true);
+
+	return result;
 }
 void                       APRSERVICE_CALL aprservice_object_destroy(struct aprservice_object* object)
 {
@@ -3378,6 +5886,8 @@ void                       APRSERVICE_CALL aprservice_object_destroy(struct aprs
 		for (auto it = service->objects.begin(); it != service->objects.end(); ++it)
 			if (&*it == object)
 			{
+				aprservice_announcer_stop(&object->announcer);
+
 				aprs_packet_deinit(object->packet);
 
 				service->objects.erase(it);
@@ -3442,6 +5952,8 @@ bool                       APRSERVICE_CALL aprservice_object_set_symbol(struct a
 		return false;
 	}
 
+	aprservice_announcer_start(object->service, &object->announcer, &aprservice_object_announcer_handler, object, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_object_set_comment(struct aprservice_object* object, const char* value)
@@ -3453,6 +5965,8 @@ bool                       APRSERVICE_CALL aprservice_object_set_comment(struct
 		return false;
 	}
 
+	aprservice_announcer_start(object->service, &object->announcer, &aprservice_object_announcer_handler, object, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_object_set_position(struct aprservice_object* object, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course)
@@ -3492,6 +6006,8 @@ bool                       APRSERVICE_CALL aprservice_object_set_position(struct
 		return false;
 	}
 
+	aprservice_announcer_start(object->service, &object->announcer, &aprservice_object_announcer_handler, object, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_object_set_compressed(struct aprservice_object* object, bool value)
@@ -3503,6 +6019,8 @@ bool                       APRSERVICE_CALL aprservice_object_set_compressed(stru
 		return false;
 	}
 
+	aprservice_announcer_start(object->service, &object->announcer, &aprservice_object_announcer_handler, object, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_object_kill(struct aprservice_object* object)
@@ -3517,6 +6035,8 @@ bool                       APRSERVICE_CALL aprservice_object_kill(struct aprserv
 		return false;
 	}
 
+	aprservice_announcer_start(object->service, &object->announcer, &aprservice_object_announcer_handler, object, true);
+
 	return true;
 }
 bool                       APRSERVICE_CALL aprservice_object_announce(struct aprservice_object* object)
@@ -3552,18 +6072,17 @@ struct aprservice_command* APRSERVICE_CALL aprservice_command_register(struct ap
 	if (!name || !handler)
 		return nullptr;
 
-	for (auto& command : service->commands)
-		if (!command.name.compare(name))
-		{
-			command.help          = help ? help : "";
-			command.filter        = nullptr;
-			command.handler       = handler;
-			command.handler_param = param;
+	if (auto command = aprservice_command_find(service, name, false))
+	{
+		command->help          = help ? help : "";
+		command->filter        = nullptr;
+		command->handler       = handler;
+		command->handler_param = param;
 
-			return &command;
-		}
+		return command;
+	}
 
-	return &service->commands.emplace_back(aprservice_command {
+	return &service->commands.emplace(aprservice_command_key(name), aprservice_command {
 		.service       = service,
 
 		.name          = name,
@@ -3571,13 +6090,13 @@ struct aprservice_command* APRSERVICE_CALL aprservice_command_register(struct ap
 
 		.handler       = handler,
 		.handler_param = param
-	});
+	})->second;
 }
 void                       APRSERVICE_CALL aprservice_command_unregister(struct aprservice_command* command)
 {
 	if (auto service = aprservice_command_get_service(command))
-		for (auto it = service->commands.begin(); it != service->commands.end(); ++it)
-			if (&*it == command)
+		for (auto [it, end] = service->commands.equal_range(aprservice_command_key(command->name)); it != end; ++it)
+			if (&it->second == command)
 			{
 				service->commands.erase(it);
 
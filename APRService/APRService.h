@@ -30,6 +30,20 @@ enum APRSERVICE_MESSAGE_ERRORS
 	APRSERVICE_MESSAGE_ERRORS_COUNT
 };
 
+// outbound packets are sent highest priority first
+enum APRSERVICE_PRIORITIES
+{
+	// acks and rejects
+	APRSERVICE_PRIORITY_ACK,
+	APRSERVICE_PRIORITY_MESSAGE,
+	// positions, status, telemetry and weather
+	APRSERVICE_PRIORITY_BEACON,
+	// items, objects and bulletins
+	APRSERVICE_PRIORITY_BULK,
+
+	APRSERVICE_PRIORITIES_COUNT
+};
+
 enum APRSERVICE_POSITION_TYPES
 {
 	APRSERVICE_POSITION_TYPE_MIC_E,
@@ -41,6 +55,7 @@ enum APRSERVICE_POSITION_TYPES
 
 struct aprservice;
 struct aprservice_item;
+struct aprservice_loop;
 struct aprservice_task;
 struct aprservice_object;
 struct aprservice_command;
@@ -49,8 +64,13 @@ struct aprservice_task_information
 {
 	const bool is_canceled;
 
+	// used to reschedule tasks from aprservice_task_schedule
 	uint32_t   seconds;
 	bool       reschedule;
+
+	// used to reschedule tasks from aprservice_task_schedule_ms
+	// capped at UINT32_MAX for tasks from aprservice_task_schedule
+	uint32_t   milliseconds;
 };
 
 struct aprservice_event_information
@@ -97,7 +117,8 @@ typedef void(APRSERVICE_CALL *aprservice_event_handler)(struct aprservice* servi
 typedef void(APRSERVICE_CALL *aprservice_command_handler)(struct aprservice* service, struct aprservice_command* command, struct aprs_packet* packet, const char* sender, const char* name, const char* args, void* param);
 typedef bool(APRSERVICE_CALL *aprservice_command_filter_handler)(struct aprservice* service, struct aprservice_command* command, struct aprs_packet* packet, const char* sender, const char* name, const char* args, void* param);
 
-typedef void(APRSERVICE_CALL *aprservice_message_callback)(struct aprservice* service, enum APRSERVICE_MESSAGE_ERRORS error, void* param);
+// attempts is the number of times the message was sent
+typedef void(APRSERVICE_CALL *aprservice_message_callback)(struct aprservice* service, enum APRSERVICE_MESSAGE_ERRORS error, uint8_t attempts, void* param);
 
 APRSERVICE_EXPORT struct aprservice*         APRSERVICE_CALL aprservice_init(const char* station, struct aprs_path* path, char symbol_table, char symbol_table_key);
 APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_deinit(struct aprservice* service);
@@ -106,9 +127,12 @@ APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_is_conne
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_is_authenticated(struct aprservice* service);
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_is_authenticating(struct aprservice* service);
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_is_monitoring_enabled(struct aprservice* service);
+APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_is_command_case_folding_enabled(struct aprservice* service);
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_is_compression_enabled(struct aprservice* service);
+APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_is_duplicate_filter_enabled(struct aprservice* service);
 APRSERVICE_EXPORT struct aprs_path*          APRSERVICE_CALL aprservice_get_path(struct aprservice* service);
 APRSERVICE_EXPORT uint32_t                   APRSERVICE_CALL aprservice_get_time(struct aprservice* service);
+APRSERVICE_EXPORT uint64_t                   APRSERVICE_CALL aprservice_get_time_ms(struct aprservice* service);
 APRSERVICE_EXPORT int                        APRSERVICE_CALL aprservice_get_time_type(struct aprservice* service);
 APRSERVICE_EXPORT const char*                APRSERVICE_CALL aprservice_get_comment(struct aprservice* service);
 APRSERVICE_EXPORT const char*                APRSERVICE_CALL aprservice_get_station(struct aprservice* service);
@@ -118,6 +142,25 @@ APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_get_posi
 APRSERVICE_EXPORT int                        APRSERVICE_CALL aprservice_get_position_type(struct aprservice* service);
 APRSERVICE_EXPORT const char*                APRSERVICE_CALL aprservice_get_command_prefix(struct aprservice* service);
 APRSERVICE_EXPORT uint32_t                   APRSERVICE_CALL aprservice_get_connection_timeout(struct aprservice* service);
+APRSERVICE_EXPORT uint32_t                   APRSERVICE_CALL aprservice_get_announce_period(struct aprservice* service);
+APRSERVICE_EXPORT uint32_t                   APRSERVICE_CALL aprservice_get_kiss_baud_rate(struct aprservice* service);
+APRSERVICE_EXPORT uint8_t                    APRSERVICE_CALL aprservice_get_kiss_duty_cycle(struct aprservice* service);
+// @return number of packets waiting to be written
+APRSERVICE_EXPORT size_t                     APRSERVICE_CALL aprservice_get_tx_queue_depth(struct aprservice* service);
+// @return milliseconds of airtime needed by packets waiting for a kiss tnc
+APRSERVICE_EXPORT uint64_t                   APRSERVICE_CALL aprservice_get_tx_pending_airtime(struct aprservice* service);
+APRSERVICE_EXPORT uint8_t                    APRSERVICE_CALL aprservice_get_message_retry_count(struct aprservice* service);
+APRSERVICE_EXPORT uint32_t                   APRSERVICE_CALL aprservice_get_message_retry_interval(struct aprservice* service);
+APRSERVICE_EXPORT uint32_t                   APRSERVICE_CALL aprservice_get_message_filter_window(struct aprservice* service);
+// @return number of retransmitted messages that were acked without being dispatched
+APRSERVICE_EXPORT uint64_t                   APRSERVICE_CALL aprservice_get_message_filter_drop_count(struct aprservice* service);
+APRSERVICE_EXPORT uint32_t                   APRSERVICE_CALL aprservice_get_duplicate_filter_window(struct aprservice* service);
+APRSERVICE_EXPORT uint64_t                   APRSERVICE_CALL aprservice_get_duplicate_filter_drop_count(struct aprservice* service);
+APRSERVICE_EXPORT size_t                     APRSERVICE_CALL aprservice_get_receive_buffer_size(struct aprservice* service);
+// @return number of lines received from APRS-IS or frames received from a TNC
+APRSERVICE_EXPORT uint64_t                   APRSERVICE_CALL aprservice_get_receive_packet_count(struct aprservice* service);
+// @return number of read calls made on the connection
+APRSERVICE_EXPORT uint64_t                   APRSERVICE_CALL aprservice_get_receive_syscall_count(struct aprservice* service);
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_get_event_handler(struct aprservice* service, enum APRSERVICE_EVENTS event, aprservice_event_handler* handler, void** param);
 APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_get_default_event_handler(struct aprservice* service, aprservice_event_handler* handler, void** param);
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_set_path(struct aprservice* service, struct aprs_path* value);
@@ -130,9 +173,32 @@ APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_set_even
 APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_set_default_event_handler(struct aprservice* service, aprservice_event_handler handler, void* param);
 APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_set_command_prefix(struct aprservice* service, const char* value);
 APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_set_connection_timeout(struct aprservice* service, uint32_t seconds);
+// items and objects are announced once per period, spread evenly across it
+// a change is announced right away and repeated at a decaying interval until the next period
+// 0 disables automatic announcements
+APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_set_announce_period(struct aprservice* service, uint32_t seconds);
+// frames are handed to a kiss tnc no faster than they can be transmitted at this rate
+// 0 disables the airtime limit and is the default
+APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_set_kiss_baud_rate(struct aprservice* service, uint32_t value);
+// percent of time the channel may be used, 1 to 100
+APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_set_kiss_duty_cycle(struct aprservice* service, uint8_t percent);
+// 0 disables retries, values above 254 are clamped so attempts fits in uint8_t
+APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_set_message_retry_count(struct aprservice* service, uint8_t value);
+// first retry is sent after seconds and each following retry waits twice as long
+APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_set_message_retry_interval(struct aprservice* service, uint32_t seconds);
+// messages received again from the same sender with the same id within seconds are acked but not dispatched
+// 0 disables the message filter
+APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_set_message_filter_window(struct aprservice* service, uint32_t seconds);
+APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_set_duplicate_filter_window(struct aprservice* service, uint32_t seconds);
+APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_set_receive_buffer_size(struct aprservice* service, size_t value);
 APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_enable_monitoring(struct aprservice* service, bool value);
+// commands are matched ignoring case, an exact match is preferred when names only differ by case
+APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_enable_command_case_folding(struct aprservice* service, bool value);
+APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_enable_duplicate_filter(struct aprservice* service, bool value);
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_poll(struct aprservice* service);
+// priority is chosen from the packet type
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_send(struct aprservice* service, struct aprs_packet* packet);
+APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_send_ex(struct aprservice* service, struct aprs_packet* packet, enum APRSERVICE_PRIORITIES priority);
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_send_raw(struct aprservice* service, const char* content);
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_send_item(struct aprservice* service, const char* name, const char* comment, char symbol_table, char symbol_table_key, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course, bool live);
 APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_send_object(struct aprservice* service, const char* name, const char* comment, char symbol_table, char symbol_table_key, float latitude, float longitude, int32_t altitude, uint16_t speed, uint16_t course, bool live);
@@ -156,8 +222,32 @@ APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_disconne
 // @return -1 on timeout
 // @return -2 on disconnect
 APRSERVICE_EXPORT int                        APRSERVICE_CALL aprservice_wait_for_io(struct aprservice* service, uint32_t timeout);
+// @return 0 on error
+// @return -1 on timeout
+// @return -2 on disconnect
+APRSERVICE_EXPORT int                        APRSERVICE_CALL aprservice_wait_for_io_ms(struct aprservice* service, uint32_t timeout);
+
+// waits on many services with one epoll or kqueue fd
+// @return nullptr if not supported on this platform
+APRSERVICE_EXPORT struct aprservice_loop*    APRSERVICE_CALL aprservice_loop_init();
+// services are removed but not deinitialized
+APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_loop_deinit(struct aprservice_loop* loop);
+// sockets are read through io_uring, writes still go through send
+// @return true if io_uring is used instead of epoll
+APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_loop_is_io_uring_enabled(struct aprservice_loop* loop);
+APRSERVICE_EXPORT size_t                     APRSERVICE_CALL aprservice_loop_get_size(struct aprservice_loop* loop);
+// @return false if service was already added to a loop
+APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_loop_add(struct aprservice_loop* loop, struct aprservice* service);
+// services are removed automatically by aprservice_deinit
+APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_loop_remove(struct aprservice_loop* loop, struct aprservice* service);
+// waits up to timeout milliseconds and polls only the services with io or tasks, messages and timeouts that are due
+// replaces aprservice_poll and aprservice_wait_for_io for every service in loop
+// @return false on error
+APRSERVICE_EXPORT bool                       APRSERVICE_CALL aprservice_loop_poll(struct aprservice_loop* loop, uint32_t timeout);
 
+// seconds is not limited to the UINT32_MAX milliseconds of aprservice_task_schedule_ms
 APRSERVICE_EXPORT struct aprservice_task*    APRSERVICE_CALL aprservice_task_schedule(struct aprservice* service, uint32_t seconds, aprservice_task_handler handler, void* param);
+APRSERVICE_EXPORT struct aprservice_task*    APRSERVICE_CALL aprservice_task_schedule_ms(struct aprservice* service, uint32_t milliseconds, aprservice_task_handler handler, void* param);
 APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_task_cancel(struct aprservice_task* task);
 APRSERVICE_EXPORT void                       APRSERVICE_CALL aprservice_task_get_handler(struct aprservice_task* task, aprservice_task_handler* handler, void** param);
 APRSERVICE_EXPORT struct aprservice*         APRSERVICE_CALL aprservice_task_get_service(struct aprservice_task* task);